@@ -6,8 +6,6 @@
 #define NX 800          /* number of X cells */
 #define NY 800
 #define N (NX*NY)
-#define NIF_X (NX+1)      /* number of interfaces */
-#define NIF_Y (NY+1)
 #define U 0.5    /* advection speed X */
 #define V 0.25   /* advection speed Y */
 #define L 1.0          /* domain length */
@@ -21,131 +19,71 @@
 #define alpha 0.000024 //diffusion speed
 #define DEBUG 1
 
-void Compute_Fluxes(const float *T, float *F,float *W,float *D,float time)
+/* Rusanov flux at an interface between left = l and right = r */
+static inline float Flux_X(float l, float r)
 {
-    /* compute flux at all interfaces j = 0..n (n+1 interfaces)
-       interface j is between left = (j-1) and right = j (mod n) */
-
-    // Only compute the inside interfaces; leave the outside 2 interfaces for later.
-//	#pragma omp parallel
-//	{
-	#pragma omp for   
-    	for (int j = 1; j < NIF_X-1; j++) {
-		for (int k = 0; k < NY; k++){
-			int index1 = j*NY+k;
-			float Left_F = U*T[index1-NY];
-			float Right_F = U*T[index1];
-			float right_T = T[index1];
-			float left_T = T[index1-NY]; 
-
-			F[index1] = 0.5 * (Left_F + Right_F) - 0.25*(right_T - left_T);
-        	}
-	}
-	#pragma omp for
-	for (int i=0; i<NY; i++){
-                F[i]=F[i+NY];
-                F[NX*NY+i]=F[(NX-1)*NY+i];
-	}
-	#pragma omp for
-	for (int j = 0; j < NX; j++) {
-                for (int k = 1; k < NIF_Y; k++){
-                        int index1 = j*NIF_Y+k;
-			int index = j*NY+k;
-                        float Top_W = V*T[index];
-                        float Bottom_W = V*T[index-1];
-                        float Top_T = T[index]; 
-                        float Bottom_T = T[index-1]; 
-
-                        W[index1] = 0.5 * (Top_W + Bottom_W) - 0.25*(Top_T - Bottom_T);
-                }
-        }
-//	printf("step %g Interface %g\n",time/DT,F[4050]);
-	#pragma omp for
-        for (int i=0; i<NX; i++){
-                W[i*NIF_Y]=W[i*NIF_Y+1];
-                W[(i+1)*NIF_Y-1]=W[(i+1)*NIF_Y-2];
-	}
-	#pragma omp for
-	for (int j = 0; j < NX; j++) {
-                for (int k = 0; k < NY; k++){
-                        int index = j*NY+k;
-                        float Bottom,Top,Left,Right;
-                        if(k == 0){
-                                Bottom = T[index];
-                        }else{
-                                Bottom = T[index-1];
-                        }
-                        if(k == (NY-1)){
-                                Top = T[index];
-                        }else{
-                                Top = T[index+1];
-                        }
-			if(j == 0){
-                                Left = T[index];
-                        }else{
-                                Left = T[index-NY];
-                        }
-                        if(j == (NX-1)){
-                                Right = T[index];
-                        }else{
-                                Right = T[index+NY];
-                        }
-
-                        D[index] = (alpha/DY/DY)*(Left+Right+Top+Bottom-4*T[index]);
-		}
-	}
-/*	for (int j = 1; j < NIF_Y; j++) {
-                for (int k = 0; k < NX; k++){
-                        int index1 = j*NX+k;
-                        W[index1] = (-alpha)*((T[index1] - T[index1-NX]) / DY);
-                }
-        }
-	printf("step %g Interface %g\n",time/DT,W[3060]);
-	for (int i=0; i<NX; i++){
-                W[i]=W[i+NX];
-                W[NX*NY+i]=W[NX*(NY-1)+i];
-        }*/
-
-
-       		//central flux
-       		// F[j] = 0.5 * (left_F + right_F);
-
-
-       		// Rusanov flux
-       		// F[j] = 0.5 * (left_F + right_F) - 0.25*(right_u - left_u);
-
-
-//	}//end of parallel
-    	// Set dF/dx = 0 on left and right ends of our domain
+	float Left_F = U*l;
+	float Right_F = U*r;
+	return 0.5 * (Left_F + Right_F) - 0.25*(r - l);
 }
 
+static inline float Flux_Y(float b, float t)
+{
+	float Bottom_W = V*b;
+	float Top_W = V*t;
+	return 0.5 * (Top_W + Bottom_W) - 0.25*(t - b);
+}
 
-void Update_State(const float *F, float *T,float *W,float *D,float *Tnew) {
+/* new value of one cell from its centre C, its 4 neighbours (already
+   mirrored on the walls) and the 4 interface fluxes around it */
+static inline float Cell_Update(float C, float Left, float Right, float Bottom, float Top,
+				float Fl, float Fr, float Wb, float Wt)
+{
+	float D = (alpha/DY/DY)*(Left+Right+Top+Bottom-4*C);
+	return C - ((DT/DX)*(Fr - Fl)) - ((DT/DY)*(Wt - Wb)) + DT*D;
+}
 
+void Compute_Step(const float *T, float *Tnew)
+{
     /*
-    Solving
-        dT/dt + dF/dx = 0
-    So
-        T* = T - dt*dF/dx
+    Fused flux + update, one pass over the grid:
+        Tnew = T - dt*dF/dx - dt*dW/dy + dt*D
+    The X flux F, the Y flux W and the diffusion term D are formed in
+    registers and only Tnew is written.  On the walls dF/dx = 0 and
+    dW/dy = 0 (F[0]=F[1], F[NX]=F[NX-1], same for W), and the diffusion
+    term mirrors the boundary cell.
     */
-//	#pragma omp parallel
-//	{
 	#pragma omp for
     	for (int j = 0; j < NX; j++) {
-                for (int k = 0; k < NY; k++){
-                        int index = j*NY+k;
-			int index1 = j*NIF_Y+k;
-        		Tnew[index] = T[index] - ((DT/DX)*(F[index+NY] - F[index])) - ((DT/DY)*(W[index1+1]-W[index1])) + DT*D[index];
-    		}
-	}
-	#pragma omp for
-	for (int j = 0; j < NX; j++) {
-                for (int k = 0; k < NY; k++){
-                        int index1 = j*NY+k; 
-                        T[index1] = Tnew[index1];
-                }
-        }
+		const float *Tc = T + j*NY;
+		const float *Tw = (j == 0) ? Tc : Tc - NY;
+		const float *Te = (j == (NX-1)) ? Tc : Tc + NY;
+		/* cells on the left/right walls see the same flux on both sides */
+		const float *FlL = (j == 0) ? Tc : Tw;
+		const float *FlR = (j == 0) ? Te : Tc;
+		const float *FrL = (j == (NX-1)) ? Tw : Tc;
+		const float *FrR = (j == (NX-1)) ? Tc : Te;
+		float *Tn = Tnew + j*NY;
+
+		float Wb, Wt;
+
+		/* bottom wall */
+		Wt = Flux_Y(Tc[0], Tc[1]);
+		Tn[0] = Cell_Update(Tc[0], Tw[0], Te[0], Tc[0], Tc[1],
+				Flux_X(FlL[0], FlR[0]), Flux_X(FrL[0], FrR[0]), Wt, Wt);
+
+		for (int k = 1; k < NY-1; k++){
+			Wb = Flux_Y(Tc[k-1], Tc[k]);
+			Wt = Flux_Y(Tc[k], Tc[k+1]);
+			Tn[k] = Cell_Update(Tc[k], Tw[k], Te[k], Tc[k-1], Tc[k+1],
+					Flux_X(FlL[k], FlR[k]), Flux_X(FrL[k], FrR[k]), Wb, Wt);
+		}
 
+		/* top wall */
+		Wb = Flux_Y(Tc[NY-2], Tc[NY-1]);
+		Tn[NY-1] = Cell_Update(Tc[NY-1], Tw[NY-1], Te[NY-1], Tc[NY-2], Tc[NY-1],
+				Flux_X(FlL[NY-1], FlR[NY-1]), Flux_X(FrL[NY-1], FrR[NY-1]), Wb, Wb);
+	}
 }
 
 
@@ -153,19 +91,13 @@ void Update_State(const float *F, float *T,float *W,float *D,float *Tnew) {
 int main(void)
 {
 	float *T;
-	float *F;
 	float *A;
 	float *Tnew;
-	float *W;
-	float *D;
-	T = (float*)malloc(NIF_X*NIF_Y*sizeof(float));
-	Tnew = (float*)malloc(NIF_X*NIF_Y*sizeof(float));
-	F = (float*)malloc(NIF_X*NY*sizeof(float));
-	A = (float*)malloc(NIF_X*NIF_Y*sizeof(float));
-	W = (float*)malloc(NIF_X*NIF_Y*sizeof(float));
-	D = (float*)malloc(NIF_X*NIF_Y*sizeof(float));
+	T = (float*)malloc(N*sizeof(float));
+	Tnew = (float*)malloc(N*sizeof(float));
+	A = (float*)malloc(N*sizeof(float));
 
-    	if (!T || !F) {
+    	if (!T || !Tnew || !A) {
         	fprintf(stderr, "allocation failed\n");
         	return 1;
     	}
@@ -209,16 +141,21 @@ int main(void)
 
 
 
+    /* T and Tnew are swapped every step instead of copied back; every
+       thread swaps its own copy of the pointers the same way */
+    float *Tcur = T;
+    float *Tnxt = Tnew;
     float time = 0.0;
     for (int timestep = 0; timestep < MAX_TIMESTEPS; timestep++) {
     
-        // Compute fluxes
-        Compute_Fluxes( T, F, W,D,time);
-
-        // Update T using Fluxes F
+        // Compute fluxes and update T in one pass
 //        printf("Computing state at time %g (using) timestep %g (after %d time steps)\n", time, DT, timestep);
 
-        Update_State(F,T,W,D,Tnew);
+        Compute_Step(Tcur, Tnxt);
+
+        float *tmp = Tcur;
+        Tcur = Tnxt;
+        Tnxt = tmp;
 
         time = time + DT;
         if (time > T_FINAL) {
@@ -229,6 +166,11 @@ int main(void)
       //  }*/
 
     }
+    #pragma omp single
+    {
+    	T = Tcur;
+    	Tnew = Tnxt;
+    }
 
 //    float Total_error = 0.0;
     #pragma omp single
@@ -270,9 +212,6 @@ int main(void)
     /* cleanup */
     free(T);
     free(Tnew);
-    free(F);
     free(A);
-    free(W);
-    free(D);
     return 0;
 }
@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "active.h"
+#include "prof.h"
+#include "sched.h"
+#include "field_alloc.h"
+
+/* ACTIVE_* of tile t of T, the edges only where a neighbour is */
+static unsigned char Scan_Tile(const struct Active_Tiles *a, const struct Kernel_2D *kn,
+			       const real *T, int t)
+{
+	int ny = kn->ny;
+	int ti = t / a->tiles_y;
+	int tk = t % a->tiles_y;
+	int j0 = ti*a->tile;
+	int j1 = Min(j0 + a->tile, kn->nx);
+	int k0 = tk*a->tile;
+	int k1 = Min(k0 + a->tile, ny);
+	real bg = a->background;
+	real eps = a->eps;
+	unsigned char s = 0;
+
+	for (int j = j0; j < j1; j++) {
+		const real *row = T + (long)j*ny;
+		int busy = 0;
+		for (int k = k0; k < k1; k++)
+			busy |= fabs(row[k] - bg) > eps;
+		if (!busy)
+			continue;
+		s |= ACTIVE_BUSY;
+		if (j == j0)
+			s |= ACTIVE_WEST;
+		if (j == j1 - 1)
+			s |= ACTIVE_EAST;
+		if (fabs(row[k0] - bg) > eps)
+			s |= ACTIVE_SOUTH;
+		if (fabs(row[k1-1] - bg) > eps)
+			s |= ACTIVE_NORTH;
+	}
+	if (ti == 0)
+		s &= ~ACTIVE_WEST;
+	if (ti == a->tiles_x - 1)
+		s &= ~ACTIVE_EAST;
+	if (tk == 0)
+		s &= ~ACTIVE_SOUTH;
+	if (tk == a->tiles_y - 1)
+		s &= ~ACTIVE_NORTH;
+	return s;
+}
+
+/* the tiles to step from the last states: the busy ones, those woken up
+   by a busy edge of a neighbour, and those needed last time (once more,
+   so both fields settle) */
+static void Schedule(struct Active_Tiles *a)
+{
+	int ty = a->tiles_y;
+	int n = a->tiles_x*ty;
+	const unsigned char *s = a->state;
+
+	a->nlist = 0;
+	for (int t = 0; t < n; t++) {
+		int ti = t / ty;
+		int tk = t % ty;
+		int need = (s[t] & ACTIVE_BUSY)
+			|| (ti > 0 && (s[t - ty] & ACTIVE_EAST))
+			|| (ti < a->tiles_x - 1 && (s[t + ty] & ACTIVE_WEST))
+			|| (tk > 0 && (s[t - 1] & ACTIVE_NORTH))
+			|| (tk < ty - 1 && (s[t + 1] & ACTIVE_SOUTH));
+		if (need || a->need[t])
+			a->list[a->nlist++] = t;
+		a->need[t] = (unsigned char)need;
+	}
+	memset(a->state, 0, n);
+	a->stepped += a->nlist;
+	a->steps++;
+}
+
+void Active_Start(struct Active_Tiles *a, const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	int ny = kn->ny;
+
+	#pragma omp for schedule(static)
+	for (int j = 0; j < kn->nx; j++)
+		memcpy(Tnew + (long)j*ny, T + (long)j*ny, ny*sizeof(real));
+
+	#pragma omp for schedule(static)
+	for (int t = 0; t < a->tiles_x*a->tiles_y; t++)
+		a->state[t] = Scan_Tile(a, kn, T, t);
+}
+
+static void Step_Tile(struct Active_Tiles *a, const struct Kernel_2D *kn,
+		      const struct Grid_View *in, const struct Grid_View *out, int t)
+{
+	int j0 = (t / a->tiles_y)*a->tile;
+	int k0 = (t % a->tiles_y)*a->tile;
+
+	kn->region(kn, in, out, j0, Min(j0 + a->tile, kn->nx), k0, Min(k0 + a->tile, kn->ny));
+	a->state[t] = Scan_Tile(a, kn, out->data, t);
+}
+
+void Active_Step_2D(struct Active_Tiles *a, const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	int ny = kn->ny;
+	struct Grid_View in = { (real*)T, 0, 0, ny };
+	struct Grid_View out = { Tnew, 0, 0, ny };
+
+	#pragma omp single
+	Schedule(a);
+
+	if (kn->sched) {
+		/* the list is in grid order, so the deques keep neighbours together */
+		Sched_Start(kn->sched, a->nlist);
+		for (int i; (i = Sched_Next(kn->sched)) >= 0; )
+			Step_Tile(a, kn, &in, &out, a->list[i]);
+	} else {
+		#pragma omp for schedule(static) nowait
+		for (int i = 0; i < a->nlist; i++)
+			Step_Tile(a, kn, &in, &out, a->list[i]);
+	}
+	PROF_BARRIER();
+}
+
+struct Active_Tiles *Active_Create(const struct Params *p)
+{
+	struct Active_Tiles *a = Work_Alloc(sizeof *a);
+	int n;
+
+	a->tile = p->active_tile;
+	a->tiles_x = (p->nx + a->tile - 1) / a->tile;
+	a->tiles_y = (p->ny + a->tile - 1) / a->tile;
+	a->background = (real)p->background;
+	a->eps = (real)p->active_eps;
+	n = a->tiles_x*a->tiles_y;
+	a->state = Work_Alloc(n);
+	a->need = Work_Alloc(n);
+	a->list = Work_Alloc(n*sizeof(int));
+	return a;
+}
+
+void Active_Free(struct Active_Tiles *a)
+{
+	if (!a)
+		return;
+	free(a->state);
+	free(a->need);
+	free(a->list);
+	free(a);
+}
+
+void Active_Print(const struct Active_Tiles *a, FILE *fp)
+{
+	int n = a->tiles_x*a->tiles_y;
+
+	fprintf(fp, "active tiles: %d of %d tiles of %d x %d, %.1f%% stepped on average\n",
+		a->nlist, n, a->tile, a->tile,
+		a->steps ? 100.0*a->stepped / ((double)a->steps*n) : 0.0);
+}
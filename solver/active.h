@@ -0,0 +1,55 @@
+#ifndef ACTIVE_H
+#define ACTIVE_H
+
+#include <stdio.h>
+#include "solver.h"
+
+/*
+   Active-tile tracking for the plain 2D step (active_tile > 0).  The
+   grid is cut into active_tile x active_tile tiles; a tile is quiet
+   while all its cells are within active_eps of the background.  A quiet
+   tile whose neighbours' facing edge cells are quiet too comes out of
+   the step unchanged, so only the other tiles are stepped (with the
+   kernel's region function).  After the step every stepped tile records
+   whether it is busy and which of its edges are, which wakes up the
+   neighbour across that edge for the next step: the bitmap grows with
+   the solution one halo at a time, and shrinks again behind it.
+
+   A tile is stepped once more after it goes quiet, so both fields hold
+   the background there before it is left alone.  With active_eps = 0
+   the result is bitwise identical to the full sweep; a small positive
+   eps also drops the tails far ahead of the pulse, within eps.
+*/
+
+/* per tile: busy, and which edges are */
+enum { ACTIVE_BUSY = 1, ACTIVE_WEST = 2, ACTIVE_EAST = 4, ACTIVE_SOUTH = 8, ACTIVE_NORTH = 16 };
+
+struct Active_Tiles {
+	int tile;
+	int tiles_x, tiles_y;
+	real background;
+	real eps;
+	unsigned char *state;   /* ACTIVE_* of the last step, 0 if not stepped */
+	unsigned char *need;    /* tiles the last state wakes up */
+	int *list;              /* tiles to step */
+	int nlist;
+
+	long stepped;           /* tiles stepped, summed over the steps */
+	long steps;
+};
+
+struct Active_Tiles *Active_Create(const struct Params *p);
+void Active_Free(struct Active_Tiles *a);
+
+/* every thread of the parallel region: Tnew := T, and the first bitmap
+   from T */
+void Active_Start(struct Active_Tiles *a, const struct Kernel_2D *kn, const real *T, real *Tnew);
+
+/* Compute_Step_2D on the active tiles; every thread of the parallel
+   region, T and Tnew swapped by the caller as usual */
+void Active_Step_2D(struct Active_Tiles *a, const struct Kernel_2D *kn, const real *T, real *Tnew);
+
+/* "active tiles: stepped fraction" */
+void Active_Print(const struct Active_Tiles *a, FILE *fp);
+
+#endif
@@ -0,0 +1,116 @@
+#include <math.h>
+#include "adaptive.h"
+#include "riemann.h"
+
+/* The reductions go into file-scope variables so that they are shared by
+   the threads of the enclosing parallel region. */
+static double rate_1d, rate_2d;
+
+double Stable_Dt_1D(const struct Kernel_1D *kn, const struct Params *p, const real *u)
+{
+	double dx = p->lx / p->nx;
+	double diffusion = 2.0*kn->alpha_dx/dx;
+
+	#pragma omp single
+	rate_1d = 0.0;
+
+	#pragma omp for schedule(static) reduction(max:rate_1d)
+	for (int i = 0; i < kn->n; i++) {
+		double r = Riemann_Wave_Speed(kn->a, u[i])/dx + diffusion;
+		if (r > rate_1d)
+			rate_1d = r;
+	}
+	return p->cfl / rate_1d;
+}
+
+double Stable_Dt_2D(const struct Kernel_2D *kn, const struct Params *p, const real *T)
+{
+	int ny = kn->ny;
+	double dx = p->lx / p->nx;
+	double dy = p->ly / p->ny;
+	double diffusion = 4.0*kn->kd;
+
+	#pragma omp single
+	rate_2d = 0.0;
+
+	#pragma omp for schedule(static) reduction(max:rate_2d)
+	for (int j = 0; j < kn->nx; j++) {
+		const real *row = T + (long)j*ny;
+		for (int k = 0; k < ny; k++) {
+			/* rusanov_speed may dissipate faster than the wave */
+			double r = fmax(Riemann_Wave_Speed(kn->u, row[k]), kn->su)/dx
+				 + fmax(Riemann_Wave_Speed(kn->v, row[k]), kn->sv)/dy + diffusion;
+			if (r > rate_2d)
+				rate_2d = r;
+		}
+	}
+	return p->cfl / rate_2d;
+}
+
+double Next_Dt(const struct Params *p, double t, double dt)
+{
+	double left = p->t_final - t;
+
+	if (dt >= left)
+		return left;
+	if (2.0*dt > left)
+		return 0.5*left;
+	return dt;
+}
+
+int Advance_Adaptive_1D(struct Kernel_1D *kn, const struct Params *p, real *u, real *F,
+			struct Snapshot_Writer *snap, struct Telemetry *tm)
+{
+	double t = 0.0;
+	int step = 0;
+
+	while (t < p->t_final && step < p->max_timesteps) {
+		double dt = Next_Dt(p, t, Stable_Dt_1D(kn, p, u));
+
+		#pragma omp single
+		Kernel_1D_Set_Dt(kn, p, dt);
+
+		Compute_Fluxes_1D(kn, u, F);
+		Update_State_1D(kn, F, u);
+
+		t = (dt == p->t_final - t) ? p->t_final : t + dt;
+		step++;
+		#pragma omp master
+		Telemetry_Push(tm, step, t, (double)kn->n*step);
+		if (Snapshot_Due(snap, step))
+			Snapshot_Take(snap, u, step, t);
+	}
+	return step;
+}
+
+int Advance_Adaptive_2D(struct Kernel_2D *kn, const struct Params *p, real **T, real **Tnew,
+			struct Snapshot_Writer *snap, struct Telemetry *tm)
+{
+	real *Tcur = *T;
+	real *Tnxt = *Tnew;
+	double t = 0.0;
+	int step = 0;
+
+	while (t < p->t_final && step < p->max_timesteps) {
+		double dt = Next_Dt(p, t, Stable_Dt_2D(kn, p, Tcur));
+
+		#pragma omp single
+		Kernel_2D_Set_Dt(kn, p, dt);
+
+		Compute_Step_2D(kn, Tcur, Tnxt);
+
+		real *tmp = Tcur;
+		Tcur = Tnxt;
+		Tnxt = tmp;
+
+		t = (dt == p->t_final - t) ? p->t_final : t + dt;
+		step++;
+		#pragma omp master
+		Telemetry_Push(tm, step, t, (double)kn->nx*kn->ny*step);
+		if (Snapshot_Due(snap, step))
+			Snapshot_Take(snap, Tcur, step, t);
+	}
+	*T = Tcur;
+	*Tnew = Tnxt;
+	return step;
+}
@@ -0,0 +1,35 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include "solver.h"
+#include "snapshot.h"
+#include "telemetry.h"
+
+/*
+   Adaptive time stepping (adaptive=1): every step takes
+
+       dt = cfl / max over cells of ( |f'(T)|/dx + |g'(T)|/dy + 4*alpha/dy^2 )
+
+   found with a parallel max-reduction over the current field, so cfl is
+   the target Courant number of the combined advection-diffusion step
+   (cfl <= 1 keeps the upwind/Rusanov step monotone).  The last steps are
+   shortened to land exactly on t_final: the final two share what is left
+   when one more full step would overshoot, so there is no sliver step.
+
+   Both drivers are called by every thread of the parallel region, change
+   the time step of the shared kernel, report every step to tm and return
+   the number of steps.
+*/
+
+double Stable_Dt_1D(const struct Kernel_1D *kn, const struct Params *p, const real *u);
+double Stable_Dt_2D(const struct Kernel_2D *kn, const struct Params *p, const real *T);
+
+/* dt shortened so that the run ends exactly on t_final */
+double Next_Dt(const struct Params *p, double t, double dt);
+
+int Advance_Adaptive_1D(struct Kernel_1D *kn, const struct Params *p, real *u, real *F,
+			struct Snapshot_Writer *snap, struct Telemetry *tm);
+int Advance_Adaptive_2D(struct Kernel_2D *kn, const struct Params *p, real **T, real **Tnew,
+			struct Snapshot_Writer *snap, struct Telemetry *tm);
+
+#endif
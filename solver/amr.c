@@ -0,0 +1,623 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "amr.h"
+#include "riemann.h"
+#include "field_alloc.h"
+
+static inline real Minmod(real a, real b)
+{
+	if (a*b <= 0)
+		return 0;
+	return fabs(a) < fabs(b) ? a : b;
+}
+
+/* block b of level lv in buffer buf, ghost ring included */
+static inline real *Block_Data(const struct Amr *amr, const struct Amr_Level *lv, int buf, int b)
+{
+	long size = (long)(amr->block + 2)*(amr->block + 2);
+	return lv->data[buf] + b*size;
+}
+
+/* cell (j,k) of level l in buffer buf, NULL where the level has no block */
+static inline real *Cell(const struct Amr *amr, int l, int buf, int j, int k)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	int B = amr->block;
+
+	if (l == 0)
+		return lv->data[buf] + (long)j*lv->p.ny + k;
+	int b = lv->map[(j/B)*lv->nby + k/B];
+	if (b < 0)
+		return NULL;
+	return Block_Data(amr, lv, buf, b) + (j%B + 1)*(B + 2) + (k%B + 1);
+}
+
+/* level l at time fraction theta of its current step: data[cur] is the
+   old state, data[cur^1] the new one */
+static inline real Value(const struct Amr *amr, int l, int j, int k, real theta)
+{
+	int cur = amr->level[l].cur;
+	real v = *Cell(amr, l, cur, j, k);
+
+	if (theta > 0)
+		v += theta*(*Cell(amr, l, cur ^ 1, j, k) - v);
+	return v;
+}
+
+/* cell (j,k) of level l from level l-1, conservative: the 4 children of
+   a coarse cell average to it.  Level 0 has no parent and keeps its own
+   value (the callers only ask for l > 0, the guard makes level[l-1]
+   provably in bounds). */
+static real Interpolate(const struct Amr *amr, int l, int j, int k, real theta)
+{
+	if (l <= 0)
+		return Value(amr, 0, j, k, theta);
+
+	const struct Amr_Level *c = &amr->level[l-1];
+	int I = j >> 1;
+	int K = k >> 1;
+	real v = Value(amr, l-1, I, K, theta);
+	real w = (I > 0) ? Value(amr, l-1, I-1, K, theta) : v;
+	real e = (I < c->p.nx - 1) ? Value(amr, l-1, I+1, K, theta) : v;
+	real s = (K > 0) ? Value(amr, l-1, I, K-1, theta) : v;
+	real n = (K < c->p.ny - 1) ? Value(amr, l-1, I, K+1, theta) : v;
+	real sx = Minmod(v - w, e - v);
+	real sy = Minmod(v - s, n - v);
+
+	return v + ((j & 1) ? 0.25f : -0.25f)*sx + ((k & 1) ? 0.25f : -0.25f)*sy;
+}
+
+/* the flux through the face between the cells L and R, in the form the
+   kernel applies it: advective part (Rusanov at the speed s) minus
+   kd*h*(R - L) */
+static inline double Face_Flux(int flux, real a, real s, double kdh, real L, real R)
+{
+	return Riemann_Flux_Speed(flux, a, s, L, R) - kdh*(R - L);
+}
+
+/* ---------------------------------------------------------------- stepping */
+
+static void Fill_Ghosts(const struct Amr *amr, int l, real theta)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	int B = amr->block;
+	int S = B + 2;
+
+	#pragma omp for schedule(static)
+	for (int b = 0; b < lv->nblocks; b++) {
+		real *base = Block_Data(amr, lv, lv->cur, b);
+		int j0 = (lv->blocks[b] / lv->nby)*B;
+		int k0 = (lv->blocks[b] % lv->nby)*B;
+
+		for (int side = 0; side < 4; side++) {
+			/* one side of the ring: cells (j, k) = start + i*step */
+			int j = (side == 0) ? j0 - 1 : (side == 1) ? j0 + B : j0;
+			int k = (side == 2) ? k0 - 1 : (side == 3) ? k0 + B : k0;
+			int dj = (side < 2) ? 0 : 1;
+			int dk = (side < 2) ? 1 : 0;
+
+			if (j < 0 || j >= lv->p.nx || k < 0 || k >= lv->p.ny)
+				continue;       /* a wall: the kernel mirrors */
+			for (int i = 0; i < B; i++, j += dj, k += dk) {
+				const real *same = Cell(amr, l, lv->cur, j, k);
+				base[(j - j0 + 1)*S + (k - k0 + 1)] = same ? *same
+							: Interpolate(amr, l, j, k, theta);
+			}
+		}
+	}
+}
+
+/* dt times the flux through every face of the coarse-fine sides, summed
+   over the two steps of the level in reg */
+static void Record_Fluxes(const struct Amr *amr, const struct Amr_Level *lv, int b, int first)
+{
+	const struct Kernel_2D *kn = &lv->kn;
+	int B = amr->block;
+	int S = B + 2;
+	const real *T = Block_Data(amr, lv, lv->cur, b) + S + 1;
+	real *reg = lv->reg + (long)b*4*B;
+	double kdx = kn->kd*lv->dx;
+	double kdy = kn->kd*lv->dy;
+
+	for (int side = 0; side < 4; side++) {
+		real *r = reg + side*B;
+		if (!(lv->cf[b] & (1 << side)))
+			continue;
+		for (int i = 0; i < B; i++) {
+			double F;
+			if (side == 0)
+				F = Face_Flux(kn->flux, kn->u, kn->su, kdx, T[i - S], T[i]);
+			else if (side == 1)
+				F = Face_Flux(kn->flux, kn->u, kn->su, kdx, T[(B-1)*S + i], T[B*S + i]);
+			else if (side == 2)
+				F = Face_Flux(kn->flux, kn->v, kn->sv, kdy, T[i*S - 1], T[i*S]);
+			else
+				F = Face_Flux(kn->flux, kn->v, kn->sv, kdy, T[i*S + B-1], T[i*S + B]);
+			r[i] = (first ? 0 : r[i]) + (real)(kn->dt*F);
+		}
+	}
+}
+
+static void Step_Blocks(const struct Amr *amr, int l, real theta)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	const struct Kernel_2D *kn = &lv->kn;
+	int B = amr->block;
+
+	Fill_Ghosts(amr, l, theta);
+
+	#pragma omp for schedule(static)
+	for (int b = 0; b < lv->nblocks; b++) {
+		int j0 = (lv->blocks[b] / lv->nby)*B;
+		int k0 = (lv->blocks[b] % lv->nby)*B;
+		struct Grid_View src = { Block_Data(amr, lv, lv->cur, b), j0 - 1, k0 - 1, B + 2 };
+		struct Grid_View dst = { Block_Data(amr, lv, lv->cur ^ 1, b), j0 - 1, k0 - 1, B + 2 };
+
+		if (lv->cf[b])
+			Record_Fluxes(amr, lv, b, theta == 0);
+		kn->region(kn, &src, &dst, j0, j0 + B, k0, k0 + B);
+	}
+}
+
+/* level l (buffer buf) under level l+1 := average of the 4 children */
+static void Average_Down(const struct Amr *amr, int l, int buf)
+{
+	const struct Amr_Level *f = &amr->level[l+1];
+	int B = amr->block;
+	int H = B/2;
+
+	#pragma omp for schedule(static)
+	for (int b = 0; b < f->nblocks; b++) {
+		const real *T = Block_Data(amr, f, f->cur, b) + (B + 2) + 1;
+		int J0 = (f->blocks[b] / f->nby)*H;
+		int K0 = (f->blocks[b] % f->nby)*H;
+
+		for (int i = 0; i < H; i++) {
+			const real *r0 = T + 2*i*(B + 2);
+			const real *r1 = r0 + (B + 2);
+			real *c = Cell(amr, l, buf, J0 + i, K0);
+			for (int m = 0; m < H; m++)
+				c[m] = 0.25f*((r0[2*m] + r0[2*m+1]) + (r1[2*m] + r1[2*m+1]));
+		}
+	}
+}
+
+/*
+   The level-l cells next to the coarse-fine sides of level l+1 were
+   updated with their own flux F through the shared face, dt_l*F/dx_l;
+   replace it by the fine fluxes, sum(dt_f*F_f)/2 over the 2 fine faces
+   and the 2 fine steps, divided by dx_l.  Serial: a cell can border
+   fine blocks on two sides.
+*/
+static void Reflux(const struct Amr *amr, int l)
+{
+	const struct Amr_Level *c = &amr->level[l];
+	const struct Amr_Level *f = &amr->level[l+1];
+	const struct Kernel_2D *kn = &c->kn;
+	int B = amr->block;
+	int H = B/2;
+	int old = c->cur;
+	double kdx = kn->kd*c->dx;
+	double kdy = kn->kd*c->dy;
+
+	#pragma omp single
+	for (int b = 0; b < f->nblocks; b++) {
+		if (!f->cf[b])
+			continue;
+		const real *reg = f->reg + (long)b*4*B;
+		int J0 = (f->blocks[b] / f->nby)*H;
+		int K0 = (f->blocks[b] % f->nby)*H;
+
+		for (int side = 0; side < 4; side++) {
+			const real *r = reg + side*B;
+			if (!(f->cf[b] & (1 << side)))
+				continue;
+			for (int m = 0; m < H; m++) {
+				double fine = 0.5*((double)r[2*m] + r[2*m+1]);
+				int J, K;               /* the coarse cell outside */
+				double Fc, d;
+				if (side == 0) {
+					J = J0 - 1, K = K0 + m;
+					Fc = Face_Flux(kn->flux, kn->u, kn->su, kdx, *Cell(amr, l, old, J, K),
+						       *Cell(amr, l, old, J+1, K));
+					d = (kn->dt*Fc - fine)/c->dx;
+				} else if (side == 1) {
+					J = J0 + H, K = K0 + m;
+					Fc = Face_Flux(kn->flux, kn->u, kn->su, kdx, *Cell(amr, l, old, J-1, K),
+						       *Cell(amr, l, old, J, K));
+					d = (fine - kn->dt*Fc)/c->dx;
+				} else if (side == 2) {
+					J = J0 + m, K = K0 - 1;
+					Fc = Face_Flux(kn->flux, kn->v, kn->sv, kdy, *Cell(amr, l, old, J, K),
+						       *Cell(amr, l, old, J, K+1));
+					d = (kn->dt*Fc - fine)/c->dy;
+				} else {
+					J = J0 + m, K = K0 + H;
+					Fc = Face_Flux(kn->flux, kn->v, kn->sv, kdy, *Cell(amr, l, old, J, K-1),
+						       *Cell(amr, l, old, J, K));
+					d = (fine - kn->dt*Fc)/c->dy;
+				}
+				*Cell(amr, l, old ^ 1, J, K) += (real)d;
+			}
+		}
+	}
+}
+
+/* one step of level l, theta = 0 or 1/2 of the step of level l-1 */
+static void Advance_Level(struct Amr *amr, int l, real theta)
+{
+	struct Amr_Level *lv = &amr->level[l];
+
+	if (l == 0)
+		Compute_Step_2D(&lv->kn, lv->data[lv->cur], lv->data[lv->cur ^ 1]);
+	else
+		Step_Blocks(amr, l, theta);
+
+	if (l + 1 < amr->nlevels && amr->level[l+1].nblocks > 0) {
+		Advance_Level(amr, l+1, 0);
+		Advance_Level(amr, l+1, 0.5f);
+		Reflux(amr, l);
+		Average_Down(amr, l, lv->cur ^ 1);
+	}
+
+	#pragma omp single
+	{
+		lv->cur ^= 1;
+		lv->updates += (l == 0) ? (long)lv->p.nx*lv->p.ny
+					: (long)lv->nblocks*amr->block*amr->block;
+	}
+}
+
+/* ---------------------------------------------------------------- regridding */
+
+/* whether block (a,b) of level l is wanted: the largest jump between
+   neighbouring cells of level l-1 under it */
+static int Wanted(const struct Amr *amr, int l, int a, int b)
+{
+	const struct Amr_Level *c = &amr->level[l-1];
+	int B = amr->block;
+	int H = B/2;
+	int J0 = a*H;
+	int K0 = b*H;
+	const real *T;
+	int stride, jmax, kmax;
+
+	/* level 0: the neighbours may be outside the footprint; a block only
+	   compares its own cells */
+	if (l == 1) {
+		T = c->data[c->cur] + (long)J0*c->p.ny + K0;
+		stride = c->p.ny;
+		jmax = Min(H, c->p.nx - 1 - J0);
+		kmax = Min(H, c->p.ny - 1 - K0);
+	} else {
+		T = Cell(amr, l-1, c->cur, J0, K0);
+		if (!T)
+			return 0;
+		stride = B + 2;
+		jmax = Min(H, B - 1 - J0 % B);
+		kmax = Min(H, B - 1 - K0 % B);
+	}
+
+	real jump = 0;
+	for (int i = 0; i < H; i++) {
+		const real *row = T + (long)i*stride;
+		for (int m = 0; m < H; m++) {
+			if (i < jmax)
+				jump = fmax(jump, fabs(row[m + stride] - row[m]));
+			if (m < kmax)
+				jump = fmax(jump, fabs(row[m + 1] - row[m]));
+		}
+	}
+	return jump > amr->threshold;
+}
+
+/* wanted blocks grown by one, plus what level l+1 needs under it */
+static void Flags_To_Want(const struct Amr *amr, int l, unsigned char *want)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	int B = amr->block;
+	int H = B/2;
+
+	for (int a = 0; a < lv->nbx; a++)
+		for (int b = 0; b < lv->nby; b++) {
+			if (!lv->flag[a*lv->nby + b])
+				continue;
+			for (int i = Max(a-1, 0); i <= Min(a+1, lv->nbx-1); i++)
+				for (int m = Max(b-1, 0); m <= Min(b+1, lv->nby-1); m++)
+					want[i*lv->nby + m] = 1;
+		}
+
+	if (l + 1 >= amr->nlevels)
+		return;
+	const struct Amr_Level *f = &amr->level[l+1];
+	for (int a = 0; a < f->nbx; a++)
+		for (int b = 0; b < f->nby; b++) {
+			if (!f->flag[a*f->nby + b])
+				continue;
+			/* its footprint grown by H cells of level l */
+			int j0 = Max((a-1)*H, 0) / B;
+			int j1 = (Min((a+2)*H, lv->p.nx) - 1) / B;
+			int k0 = Max((b-1)*H, 0) / B;
+			int k1 = (Min((b+2)*H, lv->p.ny) - 1) / B;
+			for (int i = j0; i <= j1; i++)
+				for (int m = k0; m <= k1; m++)
+					want[i*lv->nby + m] = 1;
+		}
+}
+
+/* the new block list of level l from want; the old map and state are
+   handed back until the blocks are copied */
+static void Rebuild_Level(struct Amr *amr, int l, const unsigned char *want,
+			  int **map, real **data)
+{
+	struct Amr_Level *lv = &amr->level[l];
+	int B = amr->block;
+	int n = 0;
+	long cells = (long)lv->nbx*lv->nby;
+
+	*map = lv->map;
+	*data = lv->data[lv->cur];
+	free(lv->data[lv->cur ^ 1]);
+	free(lv->blocks);
+	free(lv->cf);
+	free(lv->reg);
+
+	lv->map = Work_Alloc(cells*sizeof(int));
+	for (long i = 0; i < cells; i++)
+		lv->map[i] = want[i] ? n++ : -1;
+	lv->nblocks = n;
+	lv->blocks = Work_Alloc(n*sizeof(int));
+	lv->cf = Work_Alloc(n);
+	for (long i = 0; i < cells; i++) {
+		int b = lv->map[i];
+		if (b < 0)
+			continue;
+		int a = (int)(i / lv->nby);
+		int m = (int)(i % lv->nby);
+		lv->blocks[b] = (int)i;
+		if (a > 0 && !want[i - lv->nby])
+			lv->cf[b] |= AMR_WEST;
+		if (a < lv->nbx - 1 && !want[i + lv->nby])
+			lv->cf[b] |= AMR_EAST;
+		if (m > 0 && !want[i - 1])
+			lv->cf[b] |= AMR_SOUTH;
+		if (m < lv->nby - 1 && !want[i + 1])
+			lv->cf[b] |= AMR_NORTH;
+	}
+
+	long size = (long)(B + 2)*(B + 2);
+	lv->data[0] = Work_Alloc(n*size*sizeof(real));
+	lv->data[1] = Work_Alloc(n*size*sizeof(real));
+	lv->reg = Work_Alloc((long)n*4*B*sizeof(real));
+	lv->cur = 0;
+}
+
+/* new blocks from level l-1, kept ones copied */
+static void Fill_Level(const struct Amr *amr, int l, const int *map, const real *data)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	int B = amr->block;
+	long size = (long)(B + 2)*(B + 2);
+
+	#pragma omp for schedule(static)
+	for (int b = 0; b < lv->nblocks; b++) {
+		real *T = Block_Data(amr, lv, lv->cur, b);
+		int i = lv->blocks[b];
+		int old = map[i];
+		if (old >= 0) {
+			memcpy(T, data + old*size, size*sizeof(real));
+			continue;
+		}
+		int j0 = (i / lv->nby)*B;
+		int k0 = (i % lv->nby)*B;
+		for (int j = 0; j < B; j++)
+			for (int k = 0; k < B; k++)
+				T[(j + 1)*(B + 2) + k + 1] = Interpolate(amr, l, j0 + j, k0 + k, 0);
+	}
+}
+
+/* the blocks being replaced, shared by the threads of the enclosing
+   parallel region */
+static int *old_map;
+static real *old_data;
+
+static void Regrid(struct Amr *amr)
+{
+	for (int l = 1; l < amr->nlevels; l++) {
+		struct Amr_Level *lv = &amr->level[l];
+		#pragma omp for schedule(static)
+		for (int i = 0; i < lv->nbx*lv->nby; i++)
+			lv->flag[i] = Wanted(amr, l, i / lv->nby, i % lv->nby);
+	}
+
+	/* finest first, so every level knows what it has to nest */
+	for (int l = amr->nlevels - 1; l >= 1; l--) {
+		struct Amr_Level *lv = &amr->level[l];
+		#pragma omp single
+		{
+			unsigned char *want = Work_Alloc((size_t)lv->nbx*lv->nby);
+			Flags_To_Want(amr, l, want);
+			memcpy(lv->flag, want, (size_t)lv->nbx*lv->nby);
+			free(want);
+		}
+	}
+
+	/* coarsest first, so new blocks are filled from the new level below */
+	for (int l = 1; l < amr->nlevels; l++) {
+		#pragma omp single
+		Rebuild_Level(amr, l, amr->level[l].flag, &old_map, &old_data);
+		Fill_Level(amr, l, old_map, old_data);
+		#pragma omp single
+		{
+			free(old_map);
+			free(old_data);
+		}
+	}
+}
+
+/* the initial condition on every level, the composite averaged down */
+static void Start(struct Amr *amr)
+{
+	int B = amr->block;
+
+	for (int pass = 1; pass < amr->nlevels; pass++) {
+		Regrid(amr);
+		for (int l = 1; l < amr->nlevels; l++) {
+			const struct Amr_Level *lv = &amr->level[l];
+			#pragma omp for schedule(static)
+			for (int b = 0; b < lv->nblocks; b++) {
+				int j0 = (lv->blocks[b] / lv->nby)*B;
+				int k0 = (lv->blocks[b] % lv->nby)*B;
+				struct Grid_View g = { Block_Data(amr, lv, lv->cur, b), j0 - 1, k0 - 1, B + 2 };
+				Pulse_Block(&lv->p, 0.0, &g, j0, j0 + B, k0, k0 + B);
+			}
+		}
+		for (int l = amr->nlevels - 2; l >= 0; l--)
+			Average_Down(amr, l, amr->level[l].cur);
+	}
+}
+
+void Amr_Advance(struct Amr *amr, real **T, real **Tnew, int nsteps, struct Telemetry *tm)
+{
+	struct Amr_Level *l0 = &amr->level[0];
+
+	#pragma omp single
+	{
+		l0->data[0] = *T;
+		l0->data[1] = *Tnew;
+		l0->cur = 0;
+	}
+
+	if (!amr->started) {
+		Start(amr);
+		#pragma omp single
+		amr->started = 1;
+	}
+
+	for (int step = 0; step < nsteps; step++) {
+		if (step > 0 && step % amr->regrid == 0)
+			Regrid(amr);
+		Advance_Level(amr, 0, 0);
+
+		/* the counts only change in singles past the next barrier */
+		#pragma omp master
+		Telemetry_Push(tm, step + 1, (step + 1)*l0->p.dt, Amr_Updates(amr));
+	}
+
+	*T = l0->data[l0->cur];
+	*Tnew = l0->data[l0->cur ^ 1];
+}
+
+/* ---------------------------------------------------------------- setup */
+
+struct Amr *Amr_Create(const struct Params *p)
+{
+	struct Amr *amr = Work_Alloc(sizeof *amr);
+	int B = p->amr_block;
+
+	amr->nlevels = p->amr_levels + 1;
+	amr->block = B;
+	amr->regrid = p->amr_regrid;
+	amr->threshold = p->amr_threshold;
+
+	for (int l = 0; l < amr->nlevels; l++) {
+		struct Amr_Level *lv = &amr->level[l];
+		lv->p = *p;
+		lv->p.nx = p->nx << l;
+		lv->p.ny = p->ny << l;
+		lv->p.dt = p->dt / (1 << l);
+		lv->dx = lv->p.lx / lv->p.nx;
+		lv->dy = lv->p.ly / lv->p.ny;
+		Kernel_2D_Init(&lv->kn, &lv->p);
+		if (l == 0)
+			continue;
+		lv->nbx = lv->p.nx / B;
+		lv->nby = lv->p.ny / B;
+		lv->map = Work_Alloc((long)lv->nbx*lv->nby*sizeof(int));
+		for (long i = 0; i < (long)lv->nbx*lv->nby; i++)
+			lv->map[i] = -1;
+		lv->flag = Work_Alloc((size_t)lv->nbx*lv->nby);
+	}
+	return amr;
+}
+
+void Amr_Free(struct Amr *amr)
+{
+	if (!amr)
+		return;
+	for (int l = 0; l < amr->nlevels; l++) {
+		struct Amr_Level *lv = &amr->level[l];
+		Kernel_2D_Free(&lv->kn);
+		if (l == 0)
+			continue;
+		free(lv->map);
+		free(lv->blocks);
+		free(lv->cf);
+		free(lv->data[0]);
+		free(lv->data[1]);
+		free(lv->reg);
+		free(lv->flag);
+	}
+	free(amr);
+}
+
+double Amr_Updates(const struct Amr *amr)
+{
+	double n = 0;
+
+	for (int l = 0; l < amr->nlevels; l++)
+		n += amr->level[l].updates;
+	return n;
+}
+
+/* sum over the leaf cells of level l of (T - exact)^2 times their area
+   in level-0 cells */
+static double Leaf_Error(const struct Amr *amr, int l)
+{
+	const struct Amr_Level *lv = &amr->level[l];
+	const struct Amr_Level *f = (l + 1 < amr->nlevels) ? &amr->level[l+1] : NULL;
+	int B = amr->block;
+	int H = B/2;
+	real *A = Work_Alloc((size_t)B*B*sizeof(real));
+	double sum = 0;
+	int tiles = (l == 0) ? (lv->p.nx / H)*(lv->p.ny / H) : lv->nblocks;
+
+	/* level 0 in tiles of H, one per level-1 block */
+	for (int t = 0; t < tiles; t++) {
+		int n = (l == 0) ? H : B;
+		int j0 = (l == 0) ? (t / (lv->p.ny / H))*H : (lv->blocks[t] / lv->nby)*B;
+		int k0 = (l == 0) ? (t % (lv->p.ny / H))*H : (lv->blocks[t] % lv->nby)*B;
+		struct Grid_View g = { A, j0, k0, n };
+
+		Pulse_Block(&lv->p, lv->p.t_final, &g, j0, j0 + n, k0, k0 + n);
+		for (int j = j0; j < j0 + n; j++)
+			for (int k = k0; k < k0 + n; k++) {
+				if (f && f->map[((2*j)/B)*f->nby + (2*k)/B] >= 0)
+					continue;
+				double e = *Cell(amr, l, lv->cur, j, k) - A[(j - j0)*n + (k - k0)];
+				sum += e*e;
+			}
+	}
+	free(A);
+	return sum / pow(4.0, l);
+}
+
+void Amr_Print(const struct Amr *amr, FILE *fp)
+{
+	const struct Amr_Level *l0 = &amr->level[0];
+	const struct Amr_Level *top = &amr->level[amr->nlevels - 1];
+	double uniform = (double)top->p.nx*top->p.ny*(double)(l0->updates / ((long)l0->p.nx*l0->p.ny))
+		       * (1 << (amr->nlevels - 1));
+	double err = 0;
+
+	for (int l = 0; l < amr->nlevels; l++)
+		err += Leaf_Error(amr, l);
+	err /= (double)l0->p.nx*l0->p.ny;
+
+	fprintf(fp, "amr: %d levels, %dx%d effective, blocks", amr->nlevels, top->p.nx, top->p.ny);
+	for (int l = 1; l < amr->nlevels; l++)
+		fprintf(fp, " %d", amr->level[l].nblocks);
+	fprintf(fp, ", %g cell updates (%.1f%% of uniform), composite error %g\n",
+		Amr_Updates(amr), 100.0*Amr_Updates(amr)/uniform, err);
+}
@@ -0,0 +1,89 @@
+#ifndef AMR_H
+#define AMR_H
+
+#include <stdio.h>
+#include "solver.h"
+#include "telemetry.h"
+
+/*
+   Block-structured adaptive mesh refinement for the explicit 2D step
+   (amr_levels > 0).  Level 0 is the whole nx x ny grid; level l has 2^l
+   times its resolution and dt/2^l, and only exists as B x B blocks
+   (B = amr_block) on a fixed block grid, each with a one cell ghost
+   ring.  Block (a,b) of level l holds the cells [a*B, a*B+B) x
+   [b*B, b*B+B) of that level and sits on B/2 x B/2 cells of level l-1.
+
+   Regridding, every amr_regrid level-0 steps: a block is wanted where
+   the jump between neighbouring cells of the level below exceeds
+   amr_threshold, grown by one block on every side, and each level is
+   nested in the one below with at least B/2 of its cells to spare.
+   New blocks are filled from the level below, kept blocks are copied.
+
+   A step of level l (subcycling): its ghost cells are copied from the
+   neighbouring block of the same level, or else interpolated from level
+   l-1 (minmod-limited linear in space, linear in time); every block is
+   advanced with the region function of a Kernel_2D set up for the
+   level; level l+1 then takes two steps of half the size.  Afterwards
+   the level-l cells under level l+1 are replaced by the average of
+   their 4 children, and the level-l cells next to it are corrected by
+   the difference between their own flux through the shared face and
+   the sum of the fine fluxes (refluxing), so the total amount of T is
+   kept to round-off.
+
+   Level 0 is stepped with the plain kernel and lives in the caller's
+   fields, which hold the composite solution averaged down on return.
+   Explicit first-order fluxes only: no MUSCL, implicit diffusion,
+   time_block, adaptive dt, snapshots or checkpoints.
+*/
+
+#define AMR_MAX_LEVELS 6
+
+/* the sides of a block, for the coarse-fine masks */
+enum { AMR_WEST = 1, AMR_EAST = 2, AMR_SOUTH = 4, AMR_NORTH = 8 };
+
+struct Amr_Level {
+	struct Params p;        /* nx, ny, dt of this level */
+	struct Kernel_2D kn;
+	double dx, dy;
+	int nbx, nby;           /* block grid (level > 0) */
+
+	int nblocks;
+	int *map;               /* nbx*nby: block number, -1 = not refined */
+	int *blocks;            /* block number -> a*nby + b */
+	unsigned char *cf;      /* per block: AMR_* sides facing level l-1 */
+	real *data[2];          /* level 0: the caller's fields, else blocks */
+	int cur;                /* data[cur] is the current state */
+	real *reg;              /* per block 4*B sums of dt*flux on the sides */
+	unsigned char *flag;    /* regrid: nbx*nby */
+
+	long updates;           /* cells stepped */
+};
+
+struct Amr {
+	int nlevels;            /* amr_levels + 1 */
+	int block;
+	int regrid;
+	double threshold;
+	int started;
+	struct Amr_Level level[AMR_MAX_LEVELS];
+};
+
+struct Amr *Amr_Create(const struct Params *p);
+void Amr_Free(struct Amr *amr);
+
+/*
+   Advances nsteps level-0 steps; called by every thread of a parallel
+   region with its own copy of *T / *Tnew, on return *T holds the result.
+   The first call builds the hierarchy around the initial condition in *T.
+   Every level-0 step goes to tm with the cells it stepped on all levels.
+*/
+void Amr_Advance(struct Amr *amr, real **T, real **Tnew, int nsteps, struct Telemetry *tm);
+
+/* cells stepped on all levels */
+double Amr_Updates(const struct Amr *amr);
+
+/* blocks per level, work against the uniform finest grid, and the
+   error over the finest cells covering each point */
+void Amr_Print(const struct Amr *amr, FILE *fp);
+
+#endif
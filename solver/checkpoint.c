@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "checkpoint.h"
+
+static int Write_Checkpoint(const struct Params *p, const char *name,
+			    const real *data, long count, int step, double time)
+{
+	char tmp[PARAM_PATH_LEN + 8];
+	struct Checkpoint_Header h;
+
+	(void)name;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+	h.version = CHECKPOINT_VERSION;
+	h.real_size = sizeof(real);
+	h.params_size = sizeof(struct Params);
+	h.step = step;
+	h.time = time;
+	h.count = count;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", p->checkpoint);
+	FILE *fp = fopen(tmp, "wb");
+	if (!fp) {
+		fprintf(stderr, "cannot open %s\n", tmp);
+		return -1;
+	}
+	int ok = fwrite(&h, sizeof(h), 1, fp) == 1
+		&& fwrite(p, sizeof(*p), 1, fp) == 1
+		&& fwrite(data, sizeof(real), count, fp) == (size_t)count;
+	if (fclose(fp) != 0 || !ok) {
+		fprintf(stderr, "cannot write %s\n", tmp);
+		return -1;
+	}
+	if (rename(tmp, p->checkpoint) != 0) {
+		fprintf(stderr, "cannot rename %s to %s\n", tmp, p->checkpoint);
+		return -1;
+	}
+	return 0;
+}
+
+int Checkpoint_Init(struct Snapshot_Writer *w, const struct Params *p, const char *name, long count)
+{
+	return Snapshot_Start(w, p, "checkpoint", name, count, p->checkpoint_every, 0.0,
+			      Write_Checkpoint);
+}
+
+/* the parameters that define the solution; everything else (t_final,
+   max_timesteps, np, simd, blocking, output ...) may change on restart */
+static int Same_Problem(const struct Params *a, const struct Params *b)
+{
+	return a->dim == b->dim && a->nx == b->nx && a->ny == b->ny
+		&& a->lx == b->lx && a->ly == b->ly
+		&& a->u == b->u && a->v == b->v && a->alpha == b->alpha
+		&& a->dt == b->dt && a->flux == b->flux && a->rusanov_speed == b->rusanov_speed
+		&& a->limiter == b->limiter && a->rk == b->rk
+		&& a->diffusion == b->diffusion
+		&& a->mg_tol == b->mg_tol && a->mg_cycles == b->mg_cycles
+		&& a->splitting == b->splitting
+		&& a->pulse_x0 == b->pulse_x0 && a->pulse_x1 == b->pulse_x1
+		&& a->pulse_y0 == b->pulse_y0 && a->pulse_y1 == b->pulse_y1
+		&& a->pulse == b->pulse && a->background == b->background
+		&& a->active_tile == b->active_tile && a->active_eps == b->active_eps;
+}
+
+int Checkpoint_Read(const struct Params *p, real *field, long count, int *step, real *time)
+{
+	struct Checkpoint_Header h;
+	struct Params saved;
+
+	FILE *fp = fopen(p->restart, "rb");
+	if (!fp) {
+		fprintf(stderr, "cannot open checkpoint %s\n", p->restart);
+		return -1;
+	}
+	if (fread(&h, sizeof(h), 1, fp) != 1
+	    || memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0
+	    || h.version != CHECKPOINT_VERSION) {
+		fprintf(stderr, "%s is not a checkpoint\n", p->restart);
+		fclose(fp);
+		return -1;
+	}
+	if (h.real_size != sizeof(real) || h.params_size != sizeof(struct Params)) {
+		fprintf(stderr, "%s was written by a different build\n", p->restart);
+		fclose(fp);
+		return -1;
+	}
+	if (fread(&saved, sizeof(saved), 1, fp) != 1 || h.count != (uint64_t)count
+	    || !Same_Problem(&saved, p)) {
+		fprintf(stderr, "%s is a checkpoint of a different problem\n", p->restart);
+		fclose(fp);
+		return -1;
+	}
+	if (fread(field, sizeof(real), count, fp) != (size_t)count) {
+		fprintf(stderr, "%s is truncated\n", p->restart);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	*step = (int)h.step;
+	*time = (real)h.time;
+	return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "snapshot.h"
+
+/*
+   Checkpoint/restart.  A checkpoint holds everything the time loop
+   needs to carry on: the parameters, the step count, the accumulated
+   time (as the loop's own `real`, so the float sum continues exactly)
+   and the field.  A restarted run is bitwise identical to one that was
+   never stopped.
+
+       header | struct Params | field (count values of real)
+
+   The file is only valid for the build that wrote it (real_size and
+   params_size are checked).  Checkpoints go through a Snapshot_Writer,
+   so the solver threads only pay for one field copy; the writer writes
+   <checkpoint>.tmp and renames it over <checkpoint>, so a crash while
+   writing leaves the previous checkpoint intact.
+*/
+
+#define CHECKPOINT_MAGIC   "SLVCHKPT"
+#define CHECKPOINT_VERSION 1
+
+struct Checkpoint_Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t real_size;
+	uint32_t params_size;
+	uint32_t pad;
+	int64_t step;
+	double time;
+	uint64_t count;
+};
+
+/* checkpoints every p->checkpoint_every steps to p->checkpoint */
+int Checkpoint_Init(struct Snapshot_Writer *w, const struct Params *p, const char *name, long count);
+
+/* Reads p->restart into field (count values) and returns the step count
+   and time it was taken at.  The saved parameters must describe the same
+   problem as p; only the run length, output and performance settings
+   may change.  0, or -1 after printing why. */
+int Checkpoint_Read(const struct Params *p, real *field, long count, int *step, real *time);
+
+#endif
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Grid-convergence study: one config on a ladder of resolutions.
+
+    ./converge.py configs/2d_a_d.cfg
+    ./converge.py configs/1d_advection.cfg --levels 100,200,400,800,1600
+    ./converge.py configs/2d_a_d.cfg --levels 100,200,400 --cores 8 flux=upwind
+
+Every level runs ./main on the config with nx (and ny, in proportion)
+set to the level and dt scaled with the grid spacing, so the CFL number
+of the config holds on every level; with adaptive=1 or dt=0 the solver
+picks dt itself.  Extra key=value arguments go to every run.
+
+The levels run concurrently.  A run costs about cells * steps, so
+n^(dim+1): the ladder is packed largest first into at most --cores
+slots, each slot running its levels one after the other, and the cores
+left over go one at a time to the slot that would finish last.  Each
+slot is bound to its own cores (and gets np to match), so a large grid
+does not share its cores with the small ones.
+
+The L1/L2/Linf errors come from the solver's "Errors" line.  The table
+holds the observed order between neighbouring levels for each norm, the
+least-squares order over the ladder, and the cost in core-seconds with
+the fitted cost-per-accuracy exponent s of  cost ~ L2^-s.  The table is
+printed and written to converge.txt.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+import numpy as np
+
+
+def read_config(path):
+    """key = value pairs of a config file, as strings"""
+    cfg = {}
+    with open(path) as fp:
+        for line in fp:
+            line = line.split("#", 1)[0].strip()
+            if "=" in line:
+                key, value = line.split("=", 1)
+                cfg[key.strip()] = value.strip()
+    return cfg
+
+
+def level_args(cfg, extra, n):
+    """the key=value arguments of the run at nx = n"""
+    nx0 = int(cfg.get("nx", n))
+    args = {"nx": n, "debug": 0, "output": "binary", "max_timesteps": 1000000000}
+    if int(cfg.get("dim", 1)) == 2:
+        args["ny"] = max(2, round(n * int(cfg.get("ny", nx0)) / nx0))
+    dt = float(extra.get("dt", cfg.get("dt", 0)))
+    if dt > 0 and not int(extra.get("adaptive", cfg.get("adaptive", 0))):
+        args["dt"] = "%.17g" % (dt * nx0 / n)
+    args.update((k, v) for k, v in extra.items() if k not in ("nx", "ny", "dt"))
+    return args
+
+
+def plan(costs, cores):
+    """slots of (cores, levels): largest first into the least loaded slot,
+    then the spare cores to the slot that finishes last"""
+    nslots = min(cores, len(costs))
+    load = [0.0] * nslots
+    levels = [[] for _ in range(nslots)]
+    for i in sorted(range(len(costs)), key=lambda i: -costs[i]):
+        s = load.index(min(load))
+        load[s] += costs[i]
+        levels[s].append(i)
+    ncores = [1] * nslots
+    for _ in range(cores - nslots):
+        s = max(range(nslots), key=lambda s: load[s] / ncores[s])
+        ncores[s] += 1
+    return [(ncores[s], levels[s]) for s in range(nslots)]
+
+
+def run_level(main, config, args, cpus, workdir):
+    """one run; (L1, L2, Linf, steps, seconds)"""
+    cmd = [main, config] + ["%s=%s" % kv for kv in args.items()]
+    t0 = time.time()
+    out = subprocess.run(cmd, cwd=workdir, capture_output=True, text=True,
+                         preexec_fn=lambda: os.sched_setaffinity(0, cpus))
+    wall = time.time() - t0
+    if out.returncode != 0:
+        raise RuntimeError("%s failed:\n%s" % (" ".join(cmd), out.stderr))
+    m = re.search(r"Errors L1 (\S+) L2 (\S+) Linf (\S+)", out.stdout)
+    if not m:
+        raise RuntimeError("%s: no Errors line" % " ".join(cmd))
+    steps, seconds = 0, wall
+    s = re.search(r"(\d+) (?:adaptive )?steps(?: in (\S+) s)?", out.stdout)
+    if s:
+        steps = int(s.group(1))
+        if s.group(2):
+            seconds = float(s.group(2))
+    return tuple(float(x) for x in m.groups()) + (steps, seconds)
+
+
+def order(h, e):
+    """least-squares slope of log e against log h"""
+    if len(h) < 2 or min(e) <= 0:
+        return float("nan")
+    return np.polyfit(np.log(h), np.log(e), 1)[0]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("config")
+    ap.add_argument("extra", nargs="*", help="key=value for every run")
+    ap.add_argument("--levels", default="100,200,400,800", help="comma-separated nx ladder")
+    ap.add_argument("--cores", type=int, default=len(os.sched_getaffinity(0)))
+    ap.add_argument("--main", default="./main")
+    opt = ap.parse_intermixed_args()
+
+    cfg = read_config(opt.config)
+    extra = dict(kv.split("=", 1) for kv in opt.extra)
+    dim = int(extra.get("dim", cfg.get("dim", 1)))
+    ladder = sorted(int(n) for n in opt.levels.split(","))
+    runs = [level_args(cfg, extra, n) for n in ladder]
+    costs = [float(n) ** (dim + 1) for n in ladder]
+    config = os.path.abspath(opt.config)
+    main_exe = os.path.abspath(opt.main)
+
+    cpus = sorted(os.sched_getaffinity(0))
+    slots = plan(costs, max(1, opt.cores))
+    result = [None] * len(ladder)
+    ncores = [0] * len(ladder)
+    errors = []
+
+    def slot(cores, levels):
+        try:
+            for i in levels:
+                args = dict(runs[i], np=len(cores))
+                with tempfile.TemporaryDirectory() as wd:
+                    result[i] = run_level(main_exe, config, args, cores, wd)
+                ncores[i] = len(cores)
+        except Exception as exc:
+            errors.append(exc)
+
+    threads, first = [], 0
+    for count, levels in slots:
+        cores = [cpus[(first + c) % len(cpus)] for c in range(count)]
+        first += count
+        print("cores %-12s nx %s" % (",".join(map(str, cores)),
+                                     " ".join(str(ladder[i]) for i in levels)))
+        threads.append(threading.Thread(target=slot, args=(cores, levels)))
+    t0 = time.time()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for exc in errors:
+        print(exc, file=sys.stderr)
+    if errors:
+        return 1
+
+    lx = float(extra.get("lx", cfg.get("lx", 1.0)))
+    h = [lx / n for n in ladder]
+    norms = [[r[k] for r in result] for k in range(3)]
+    cost = [r[4] * c for r, c in zip(result, ncores)]
+
+    lines = ["%6s %10s %3s %8s %10s %11s %11s %11s %6s %6s %6s" %
+             ("nx", "h", "np", "steps", "core-s", "L1", "L2", "Linf", "p1", "p2", "pinf")]
+    for i, n in enumerate(ladder):
+        p = ["%6.2f" % order(h[i-1:i+1], [e[i-1], e[i]]) if i else "%6s" % "-"
+             for e in norms]
+        lines.append("%6d %10.4g %3d %8s %10.4g %11.4e %11.4e %11.4e %s" %
+                     (n, h[i], ncores[i], result[i][3] or "-", cost[i],
+                      norms[0][i], norms[1][i], norms[2][i], " ".join(p)))
+    lines.append("observed order (least squares): L1 %.3f  L2 %.3f  Linf %.3f" %
+                 tuple(order(h, e) for e in norms))
+    s = -order(norms[1], cost)
+    lines.append("cost per accuracy: core-s ~ L2^-%.3f" % s)
+    for i in range(1, len(ladder)):
+        gain = norms[1][i-1] / norms[1][i]
+        lines.append("  nx %d -> %d: L2 / %.3g for %.3g x the core-s" %
+                     (ladder[i-1], ladder[i], gain, cost[i] / cost[i-1]))
+    lines.append("%d levels on %d cores in %.3g s" % (len(ladder), opt.cores, time.time() - t0))
+
+    text = "\n".join(lines) + "\n"
+    sys.stdout.write(text)
+    with open("converge.txt", "w") as fp:
+        fp.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
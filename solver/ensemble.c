@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "ensemble.h"
+#include "solver.h"
+#include "riemann.h"
+#include "field_alloc.h"
+
+#define MAX_SWEEP 256
+
+struct Ensemble {
+	int members;
+	int lanes;              /* members padded to ENSEMBLE_CHUNK */
+	double *u, *v, *alpha;  /* per member */
+	real *a, *b;            /* per lane: u and v in working precision */
+	double *kd;             /* per lane: alpha/dx (1D), alpha/dy^2 (2D) */
+	real *ha, *hb, *kdr;    /* per lane, 2D: Rusanov 0.5*|u|, 0.5*|v|
+				   (or 0.5*rusanov_speed), kd */
+};
+
+/* "0.1, 0.2,0.5" -> values; an empty list is the single default */
+static int Parse_List(const char *s, double def, double *val)
+{
+	int n = 0;
+
+	while (*s) {
+		char *end;
+		double x = strtod(s, &end);
+		if (end == s || n == MAX_SWEEP)
+			return -1;
+		val[n++] = x;
+		s = end;
+		while (*s == ' ' || *s == '\t')
+			s++;
+		if (*s == ',')
+			s++;
+		else if (*s)
+			return -1;
+	}
+	if (n == 0)
+		val[n++] = def;
+	return n;
+}
+
+int Ensemble_Enabled(const struct Params *p)
+{
+	return p->sweep_u[0] || p->sweep_v[0] || p->sweep_alpha[0];
+}
+
+/* every combination of the three lists, alpha varying fastest */
+static int Ensemble_Init(struct Ensemble *e, const struct Params *p)
+{
+	static double us[MAX_SWEEP], vs[MAX_SWEEP], as[MAX_SWEEP];
+	int nu = Parse_List(p->sweep_u, p->u, us);
+	int nv = Parse_List(p->sweep_v, p->v, vs);
+	int na = Parse_List(p->sweep_alpha, p->alpha, as);
+	double dx = p->lx / p->nx;
+	double dy = p->ly / p->ny;
+
+	if (nu < 0 || nv < 0 || na < 0) {
+		fprintf(stderr, "sweep_u, sweep_v and sweep_alpha take up to %d comma-separated numbers\n",
+			MAX_SWEEP);
+		return -1;
+	}
+	e->members = nu*nv*na;
+	e->lanes = (e->members + ENSEMBLE_CHUNK - 1) / ENSEMBLE_CHUNK * ENSEMBLE_CHUNK;
+	e->u = Work_Alloc(e->members*sizeof(double));
+	e->v = Work_Alloc(e->members*sizeof(double));
+	e->alpha = Work_Alloc(e->members*sizeof(double));
+	e->a = Work_Alloc(e->lanes*sizeof(real));
+	e->b = Work_Alloc(e->lanes*sizeof(real));
+	e->kd = Work_Alloc(e->lanes*sizeof(double));
+	e->ha = Work_Alloc(e->lanes*sizeof(real));
+	e->hb = Work_Alloc(e->lanes*sizeof(real));
+	e->kdr = Work_Alloc(e->lanes*sizeof(real));
+
+	for (int m = 0; m < e->lanes; m++) {
+		/* padding lanes repeat the last member */
+		int i = (m < e->members) ? m : e->members - 1;
+		int iu = i / (nv*na);
+		int iv = (i / na) % nv;
+		int ia = i % na;
+		if (m < e->members) {
+			e->u[m] = us[iu];
+			e->v[m] = vs[iv];
+			e->alpha[m] = as[ia];
+		}
+		e->a[m] = (real)us[iu];
+		e->b[m] = (real)vs[iv];
+		e->kd[m] = (p->dim == 1) ? as[ia]/dx : as[ia]/dy/dy;
+		e->ha[m] = (real)0.5*(e->a[m] < 0 ? -e->a[m] : e->a[m]);
+		e->hb[m] = (real)0.5*(e->b[m] < 0 ? -e->b[m] : e->b[m]);
+		if (p->flux == FLUX_RUSANOV && p->rusanov_speed > 0.0)
+			e->ha[m] = e->hb[m] = (real)0.5*(real)p->rusanov_speed;
+		e->kdr[m] = (real)e->kd[m];
+	}
+	return 0;
+}
+
+static void Ensemble_Free(struct Ensemble *e)
+{
+	free(e->u);
+	free(e->v);
+	free(e->alpha);
+	free(e->a);
+	free(e->b);
+	free(e->kd);
+	free(e->ha);
+	free(e->hb);
+	free(e->kdr);
+}
+
+/* ---------------------------------------------------------------- kernels */
+
+/* the lanes [m0, m1) of one step of Fluxes_1D_Body + Update_1D_Body */
+static inline __attribute__((always_inline))
+void Step_1D_Body(const struct Ensemble *e, real *u, real *F, int n, double dtdx,
+		  int m0, int m1, int flux)
+{
+	int M = e->lanes;
+	const real *a = e->a;
+	const double *ad = e->kd;
+
+	for (int j = 1; j < n; j++) {
+		const real *l = u + (long)(j-1)*M;
+		const real *r = l + M;
+		real *f = F + (long)j*M;
+		#pragma omp simd
+		for (int m = m0; m < m1; m++) {
+			real x = Riemann_Flux(flux, a[m], l[m], r[m]);
+			f[m] = x - ad[m]*(r[m] - l[m]);
+		}
+	}
+	for (int c = 1; c < n-1; c++) {
+		real *uc = u + (long)c*M;
+		const real *f = F + (long)c*M;
+		#pragma omp simd
+		for (int m = m0; m < m1; m++)
+			uc[m] = uc[m] - dtdx*(f[m + M] - f[m]);
+	}
+}
+
+/* riemann.h for one lane, in the working precision; ha is the Rusanov
+   (and Roe) dissipation 0.5*|a|, or 0.5*rusanov_speed.  The upwind selects pick the operand,
+   not the product, so the lane loops if-convert. */
+static inline __attribute__((always_inline))
+real Lane_Flux(int flux, real a, real ha, real l, real r)
+{
+	switch (flux) {
+	case FLUX_UPWIND:
+		return a*((a > 0) ? l : r);
+	case FLUX_HLL:
+		return a*((a >= 0) ? l : r);
+	case FLUX_CENTRAL:
+		return (real)0.5*(a*l + a*r);
+	default:
+		return (real)0.5*(a*l + a*r) - ha*(r - l);
+	}
+}
+
+/* per-chunk state of Step_2D_Body */
+struct Lane_Ctx {
+	const real *a, *b, *ha, *hb, *kd;
+	real dtdx, dtdy, dt;
+	long M;
+	int L;
+};
+
+/* cells k0 <= k < k1 of one column; the wall flags are constants at
+   every call, so each copy is a straight vector loop over the lanes */
+static inline __attribute__((always_inline))
+void Lane_Cells(const struct Lane_Ctx *c, const real *Tc, const real *Tw, const real *Te,
+		real *Tn, real *xf, real *wf, int k0, int k1, int ny, int flux,
+		int west, int east, int bottom, int top)
+{
+	for (int k = k0; k < k1; k++) {
+		long o = k*c->M;
+		long ob = bottom ? o : o - c->M;
+		long ot = (k == ny-1) ? o : o + c->M;
+		real *xk = xf + (long)k*c->L;
+		#pragma omp simd
+		for (int m = 0; m < c->L; m++) {
+			real C = Tc[o+m];
+			real X = xk[m];
+			real Wb = wf[m];
+			real Fr = Lane_Flux(flux, c->a[m], c->ha[m], C, Te[o+m]);
+			real Wt = Lane_Flux(flux, c->b[m], c->hb[m], C, Tc[ot+m]);
+			Fr = east ? X : Fr;
+			real Fl = west ? Fr : X;
+			Wt = top ? Wb : Wt;
+			Wb = bottom ? Wt : Wb;
+			xk[m] = Fr;
+			wf[m] = Wt;
+			real D = c->kd[m]*(Tw[o+m] + Te[o+m] + Tc[ot+m] + Tc[ob+m] - 4*C);
+			Tn[o+m] = C - c->dtdx*(Fr - Fl) - c->dtdy*(Wt - Wb) + c->dt*D;
+		}
+	}
+}
+
+static inline __attribute__((always_inline))
+void Lane_Column(const struct Lane_Ctx *c, const real *Tc, const real *Tw, const real *Te,
+		 real *Tn, real *xf, real *wf, int ny, int flux, int west, int east)
+{
+	Lane_Cells(c, Tc, Tw, Te, Tn, xf, wf, 0, 1, ny, flux, west, east, 1, 0);
+	Lane_Cells(c, Tc, Tw, Te, Tn, xf, wf, 1, ny-1, ny, flux, west, east, 0, 0);
+	if (ny > 1)
+		Lane_Cells(c, Tc, Tw, Te, Tn, xf, wf, ny-1, ny, ny, flux, west, east, 0, 1);
+}
+
+/*
+   The lanes [m0, m1) of one 2D step, with the walls of Step_2D_Row.
+   Every face flux is evaluated once, as in the default row kernel: the
+   east face of column j is kept in xf (ny x lanes) as the west face of
+   column j+1, and the top face of cell k in wf as the bottom face of
+   cell k+1.  All lane arithmetic is in real, so a member agrees with a
+   single run to rounding, not bitwise.
+*/
+static inline __attribute__((always_inline))
+void Step_2D_Body(const struct Ensemble *e, const real *T, real *Tnew, int nx, int ny,
+		  real dtdx, real dtdy, real dt, int m0, int m1, real *xf, real *wf, int flux)
+{
+	struct Lane_Ctx c = { e->a + m0, e->b + m0, e->ha + m0, e->hb + m0, e->kdr + m0,
+			      dtdx, dtdy, dt, e->lanes, m1 - m0 };
+	long row = (long)ny*c.M;
+
+	for (int j = 0; j < nx; j++) {
+		const real *Tc = T + j*row + m0;
+		const real *Tw = (j == 0) ? Tc : Tc - row;
+		const real *Te = (j == nx-1) ? Tc : Tc + row;
+		real *Tn = Tnew + j*row + m0;
+
+		if (j == 0)
+			Lane_Column(&c, Tc, Tw, Te, Tn, xf, wf, ny, flux, 1, 0);
+		else if (j == nx-1)
+			Lane_Column(&c, Tc, Tw, Te, Tn, xf, wf, ny, flux, 0, 1);
+		else
+			Lane_Column(&c, Tc, Tw, Te, Tn, xf, wf, ny, flux, 0, 0);
+	}
+}
+
+typedef void (*Ens_1D_Fn)(const struct Ensemble *e, real *u, real *F, int n, double dtdx, int m0, int m1);
+typedef void (*Ens_2D_Fn)(const struct Ensemble *e, const real *T, real *Tnew, int nx, int ny,
+			  real dtdx, real dtdy, real dt, int m0, int m1, real *xf, real *wf);
+
+#define ENSEMBLE_KERNELS(FLUX, NAME)                                                             \
+static void Ens_1D_##NAME(const struct Ensemble *e, real *u, real *F, int n, double dtdx,         \
+			  int m0, int m1)                                                        \
+{                                                                                                \
+	Step_1D_Body(e, u, F, n, dtdx, m0, m1, FLUX);                                            \
+}                                                                                                \
+static void Ens_2D_##NAME(const struct Ensemble *e, const real *T, real *Tnew, int nx, int ny,    \
+			  real dtdx, real dtdy, real dt, int m0, int m1, real *xf, real *wf)     \
+{                                                                                                \
+	Step_2D_Body(e, T, Tnew, nx, ny, dtdx, dtdy, dt, m0, m1, xf, wf, FLUX);                  \
+}
+RIEMANN_SCHEMES(ENSEMBLE_KERNELS)
+
+#define ENSEMBLE_ENTRY_1D(FLUX, NAME) [FLUX] = Ens_1D_##NAME,
+#define ENSEMBLE_ENTRY_2D(FLUX, NAME) [FLUX] = Ens_2D_##NAME,
+static const Ens_1D_Fn ens_1d[NUM_FLUX_SCHEMES] = { RIEMANN_SCHEMES(ENSEMBLE_ENTRY_1D) };
+static const Ens_2D_Fn ens_2d[NUM_FLUX_SCHEMES] = { RIEMANN_SCHEMES(ENSEMBLE_ENTRY_2D) };
+
+/* ---------------------------------------------------------------- driver */
+
+/* L1, L2, Linf of member m of the interleaved field against the exact
+   pulse for its u, v */
+static void Member_Errors(const struct Ensemble *e, const struct Params *p, const real *T,
+			  int m, real *A, double norm[3])
+{
+	struct Params q = *p;
+	long n = (long)p->nx*p->ny;
+	struct Grid_View g = { A, 0, 0, p->ny };
+
+	q.u = e->u[m];
+	q.v = e->v[m];
+	Pulse_Block(&q, q.t_final, &g, 0, q.nx, 0, q.ny);
+	norm[0] = norm[1] = norm[2] = 0.0;
+	for (long i = 0; i < n; i++) {
+		double d = fabs((double)T[i*e->lanes + m] - A[i]);
+		norm[0] += d;
+		norm[1] += d*d;
+		if (d > norm[2] || d != d)
+			norm[2] = d;
+	}
+	norm[0] /= n;
+	norm[1] = sqrt(norm[1] / n);
+}
+
+static void Print_Table(const struct Ensemble *e, const struct Params *p, const real *T, FILE *fp)
+{
+	real *A = Work_Alloc((size_t)p->nx*p->ny*sizeof(real));
+
+	fprintf(fp, "%6s %10s %10s %10s %12s %12s %12s\n", "member", "u", "v", "alpha", "L1", "L2", "Linf");
+	for (int m = 0; m < e->members; m++) {
+		double norm[3];
+		Member_Errors(e, p, T, m, A, norm);
+		fprintf(fp, "%6d %10g %10g %10g %12.5e %12.5e %12.5e\n", m, e->u[m],
+			p->dim == 2 ? e->v[m] : 0.0, e->alpha[m], norm[0], norm[1], norm[2]);
+	}
+	free(A);
+}
+
+int Ensemble_Run(const struct Params *p)
+{
+	struct Ensemble e;
+	int nx = p->nx;
+	int ny = p->ny;
+	long cells = (long)nx*ny;
+
+	if (Ensemble_Init(&e, p) != 0)
+		return 1;
+
+	long M = e.lanes;
+	real *T = Field_Alloc(p, cells*M);
+	real *W = Field_Alloc(p, (p->dim == 1 ? cells + 1 : cells)*M);
+	if (!T || !W) {
+		fprintf(stderr, "allocation failed\n");
+		return 1;
+	}
+
+	int nsteps = Count_Timesteps(p);
+	int chunks = e.lanes / ENSEMBLE_CHUNK;
+	int nthreads = p->np < chunks ? p->np : chunks;
+	double dtdx = p->dt / (p->lx / nx);
+	double dtdy = p->dt / (p->ly / ny);
+	double t_start = 0.0, t_end = 0.0;
+
+	omp_set_num_threads(nthreads);
+	#pragma omp parallel
+	{
+	int t = omp_get_thread_num();
+	int nt = omp_get_num_threads();
+	int m0 = ENSEMBLE_CHUNK*(int)((long)chunks*t/nt);
+	int m1 = ENSEMBLE_CHUNK*(int)((long)chunks*(t+1)/nt);
+
+	Pin_Threads(p);
+
+	/* the same pulse in every lane, first touched by its thread */
+	{
+		real *row = Work_Alloc(ny*sizeof(real));
+		struct Grid_View g = { row, 0, 0, ny };
+		for (int j = 0; j < nx; j++) {
+			g.oj = j;
+			Pulse_Block(p, 0.0, &g, j, j+1, 0, ny);
+			for (int k = 0; k < ny; k++) {
+				real *c = T + ((long)j*ny + k)*M;
+				real *w = W + ((long)j*ny + k)*M;
+				for (int m = m0; m < m1; m++) {
+					c[m] = row[k];
+					w[m] = 0;
+				}
+			}
+		}
+		free(row);
+	}
+
+	#pragma omp barrier
+	#pragma omp master
+	t_start = omp_get_wtime();
+
+	if (p->dim == 1) {
+		Ens_1D_Fn step = ens_1d[p->flux];
+		for (int s = 0; s < nsteps; s++)
+			step(&e, T, W, nx, dtdx, m0, m1);
+	} else {
+		Ens_2D_Fn step = ens_2d[p->flux];
+		real *cur = T;
+		real *nxt = W;
+		real *xf = Work_Alloc(((long)ny + 1)*(m1 - m0)*sizeof(real));
+		real *wf = xf + (long)ny*(m1 - m0);
+		for (int s = 0; s < nsteps; s++) {
+			step(&e, cur, nxt, nx, ny, (real)dtdx, (real)dtdy, (real)p->dt, m0, m1, xf, wf);
+			real *tmp = cur;
+			cur = nxt;
+			nxt = tmp;
+		}
+		free(xf);
+		/* every thread swapped the same number of times */
+		#pragma omp master
+		if (cur != T) {
+			W = T;
+			T = cur;
+		}
+	}
+
+	#pragma omp barrier
+	#pragma omp master
+	t_end = omp_get_wtime();
+	}//end of parallel
+
+	printf("ensemble: %d members on %d threads, %d steps in %g s, %g member cell updates/s\n",
+	       e.members, nthreads, nsteps, t_end - t_start,
+	       (double)e.members*cells*nsteps / (t_end - t_start));
+	Print_Table(&e, p, T, stdout);
+
+	FILE *fp = fopen("ensemble.txt", "w");
+	if (fp) {
+		Print_Table(&e, p, T, fp);
+		fclose(fp);
+	}
+
+	Field_Free(T);
+	Field_Free(W);
+	Ensemble_Free(&e);
+	return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "params.h"
+
+/*
+   Ensemble mode: sweep_u, sweep_v and sweep_alpha take comma-separated
+   lists, and every combination (u, v, alpha) is one member of a single
+   run.  The fields are stored member-innermost,
+
+       1D: u[i*lanes + m]          2D: T[(j*ny + k)*lanes + m]
+
+   so every stencil access is a contiguous vector of members and the
+   per-cell loops vectorize across the ensemble even for tiny grids.
+   The members are padded to a multiple of ENSEMBLE_CHUNK lanes and each
+   thread advances its own chunks over all the steps, without any
+   synchronization.
+
+   In 1D each member goes through the arithmetic of kernel1d.c and
+   matches a single run with its parameters bitwise.  The 2D lanes keep
+   the face fluxes across the columns and rows like kernel2d.c but
+   compute in real, so they agree with a single run to rounding; with
+   16 members on one thread they beat sequential single runs by 1.3x
+   (rusanov, 200x200) down to about even (rusanov, 64x48), and by
+   2.4-2.7x for upwind.  All members share dt and t_final.  The result
+   is one table of L1 (mean |e|), L2 (rms) and Linf errors against the
+   analytic solution per member, on stdout and in ensemble.txt.
+*/
+
+#define ENSEMBLE_CHUNK 16
+
+/* whether any sweep_* list is given */
+int Ensemble_Enabled(const struct Params *p);
+
+int Ensemble_Run(const struct Params *p);
+
+#endif
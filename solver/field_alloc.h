@@ -0,0 +1,51 @@
+#ifndef FIELD_ALLOC_H
+#define FIELD_ALLOC_H
+
+#include "solver.h"
+
+/*
+   NUMA placement of the field arrays.
+
+   Linux puts a page on the node of the thread that first writes it, so
+   the arrays are allocated untouched (Field_Alloc) and then first
+   written inside the parallel region with the same static row partition
+   the kernels use (Field_First_Touch, Pulse_Region).  With pin=1 every
+   thread is bound to one CPU, so it stays next to its pages.
+
+   huge_pages=1 aligns the arrays of at least 2 MiB to 2 MiB and asks for
+   transparent huge pages (madvise), which cuts TLB misses on the large
+   grids; smaller arrays keep 4 KiB pages.  A huge page is placed as a
+   whole, so the partition is only followed to 2 MiB granularity (640
+   rows of an 800-wide float grid).
+
+   The work arrays of the 2D solvers (MUSCL stage, ADI and multigrid
+   buffers) are first touched the same way by Kernel_2D_First_Touch.
+*/
+
+#define HUGE_PAGE_SIZE (2L << 20)
+
+/* n values, not yet touched (apart from one word in front of them);
+   release with Field_Free.  NULL on failure. */
+real *Field_Alloc(const struct Params *p, long n);
+void Field_Free(real *f);
+
+/* zeroed memory for the smaller work arrays and structs; exits on
+   failure, so callers need no checks.  Release with free. */
+void *Work_Alloc(size_t bytes);
+
+/* the same starting on a cache line of its own, for per-thread flags
+   and counters */
+void *Work_Alloc_Aligned(size_t bytes);
+
+static inline int Min(int a, int b) { return a < b ? a : b; }
+static inline int Max(int a, int b) { return a > b ? a : b; }
+
+/* Zeroes rows x row_len values with "omp for schedule(static)" over the
+   rows; called by every thread of the parallel region. */
+void Field_First_Touch(real *f, long rows, long row_len);
+
+/* with p->pin, binds the calling thread to the omp_get_thread_num()-th
+   CPU it is allowed to run on; called by every thread */
+void Pin_Threads(const struct Params *p);
+
+#endif
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "field_io.h"
+
+_Static_assert(sizeof(struct Field_Header) <= FIELD_HEADER_SIZE, "field header too large");
+
+static uint64_t Align_Up(uint64_t x)
+{
+	return (x + FIELD_ALIGN - 1) / FIELD_ALIGN * FIELD_ALIGN;
+}
+
+uint64_t Field_Header_Init(struct Field_Header *h, const struct Params *p, long step, double time,
+			   int nvars, const struct Field_Var *vars)
+{
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, FIELD_MAGIC, sizeof(h->magic));
+	h->version = FIELD_VERSION;
+	h->header_size = FIELD_HEADER_SIZE;
+	h->dim = p->dim;
+	h->nx = p->nx;
+	h->ny = p->ny;
+	h->nvars = nvars;
+	h->real_size = sizeof(real);
+	h->step = step;
+	h->time = time;
+	h->lx = p->lx;
+	h->ly = p->ly;
+
+	uint64_t size = FIELD_HEADER_SIZE;
+	for (int v = 0; v < nvars; v++) {
+		strncpy(h->var[v].name, vars[v].name, FIELD_NAME_LEN - 1);
+		h->var[v].count = vars[v].count;
+		h->var[v].offset = size;
+		size = Align_Up(size + vars[v].count*sizeof(real));
+	}
+	return size;
+}
+
+int Field_Write(const char *path, const struct Params *p, long step, double time,
+		int nvars, const struct Field_Var *vars)
+{
+	if (nvars < 1 || nvars > FIELD_MAX_VARS) {
+		fprintf(stderr, "%s: %d variables, at most %d fit\n", path, nvars, FIELD_MAX_VARS);
+		return -1;
+	}
+
+	struct Field_Header h;
+	uint64_t size = Field_Header_Init(&h, p, step, time, nvars, vars);
+
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	if (ftruncate(fd, size) != 0) {
+		fprintf(stderr, "cannot size %s: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "cannot map %s: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	/* ftruncate left the padding zeroed */
+	memcpy(map, &h, sizeof(h));
+	for (int v = 0; v < nvars; v++)
+		memcpy(map + h.var[v].offset, vars[v].data, vars[v].count*sizeof(real));
+
+	munmap(map, size);
+	close(fd);
+	return 0;
+}
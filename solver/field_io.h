@@ -0,0 +1,67 @@
+#ifndef FIELD_IO_H
+#define FIELD_IO_H
+
+#include <stdint.h>
+#include "solver.h"
+
+/*
+   Binary field files (.fld), replacing the per-cell fprintf dumps.
+
+   A fixed FIELD_HEADER_SIZE byte header, then the raw arrays, each one
+   starting on a FIELD_ALIGN byte boundary.  Everything is in the byte
+   order of the machine that wrote it (little endian on every target of
+   this solver) and the values are `real`, so real_size tells float from
+   double.  2D arrays are stored the way the solver holds them, x index
+   slowest: T[i*ny + j].
+
+   read_field.py maps them into numpy without a copy.
+*/
+
+#define FIELD_MAGIC       "SLVFIELD"
+#define FIELD_VERSION     1
+#define FIELD_HEADER_SIZE 4096
+#define FIELD_ALIGN       64
+#define FIELD_MAX_VARS    8
+#define FIELD_NAME_LEN    16
+
+struct Field_Var_Header {
+	char name[FIELD_NAME_LEN];   /* NUL padded */
+	uint64_t count;              /* number of values */
+	uint64_t offset;             /* byte offset from the start of the file */
+};
+
+struct Field_Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t dim;
+	uint32_t nx;
+	uint32_t ny;
+	uint32_t nvars;
+	uint32_t real_size;          /* 4 = float, 8 = double */
+	uint32_t pad;
+	int64_t step;
+	double time;
+	double lx;
+	double ly;
+	struct Field_Var_Header var[FIELD_MAX_VARS];
+};
+
+/* one array to write */
+struct Field_Var {
+	const char *name;
+	const real *data;
+	long count;
+};
+
+/* Fills in the header for nvars arrays; returns the file size.  For
+   writers that place the data themselves (mpi_main.c). */
+uint64_t Field_Header_Init(struct Field_Header *h, const struct Params *p, long step, double time,
+			   int nvars, const struct Field_Var *vars);
+
+/* Writes the header and the nvars arrays to path through one shared
+   mapping of the whole file.  Returns 0, or -1 after printing why. */
+int Field_Write(const char *path, const struct Params *p, long step, double time,
+		int nvars, const struct Field_Var *vars);
+
+#endif
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "implicit.h"
+#include "simd.h"
+#include "field_alloc.h"
+
+/*
+   Forward-elimination coefficients of the n x n tridiagonal matrix with
+   off-diagonal -r and diagonal b_end on the first and last row, b_mid
+   elsewhere.  The Thomas solve is then
+
+       d'[i] = (d[i] + r*d'[i-1]) * inv[i]
+       x[i]  = d'[i] - cp[i]*x[i+1]
+*/
+static void Thomas_Coeffs(int n, double r, double b_end, double b_mid, real *cp, real *inv)
+{
+	double c = 0.0;
+
+	for (int i = 0; i < n; i++) {
+		double b = (i == 0 || i == n-1) ? b_end : b_mid;
+		double den = b + r*c;
+		c = -r / den;
+		cp[i] = (real)c;
+		inv[i] = (real)(1.0 / den);
+	}
+}
+
+/* ---------------------------------------------------------------- 1D */
+
+/*
+   Crank-Nicolson on the cells [1, n-1):
+
+       (1+r) u'[i] - r/2 (u'[i-1] + u'[i+1]) = (1-r) u[i] + r/2 (u[i-1] + u[i+1])
+
+   with u[0] and u[n-1] known at both time levels.
+*/
+static void Diffuse_1D(const struct Implicit_1D *m, real *u)
+{
+	int n = m->n;
+	double r = m->r;
+	double h = 0.5*r;
+	const real *cp = m->cp;
+	const real *inv = m->inv;
+	real *d = m->d;
+	double prev = 0.0;
+
+	for (int i = 1; i < n-1; i++) {
+		double rhs = (1.0 - r)*u[i] + h*(u[i-1] + u[i+1]);
+		if (i == 1)
+			rhs += h*u[0];
+		if (i == n-2)
+			rhs += h*u[n-1];
+		prev = (rhs + h*prev)*inv[i-1];
+		d[i-1] = (real)prev;
+	}
+
+	double x = 0.0;
+	for (int i = n-2; i >= 1; i--) {
+		x = d[i-1] - cp[i-1]*x;
+		u[i] = (real)x;
+	}
+}
+
+/* the 1D problem is a single line: solved by one thread */
+void Implicit_1D_Diffuse(const struct Implicit_1D *m, real *u)
+{
+	#pragma omp single
+	Diffuse_1D(m, u);
+}
+
+void Implicit_1D_Set_Dt(struct Implicit_1D *m, double dt)
+{
+	m->r = m->ad*dt;
+	if (m->n > 2)
+		Thomas_Coeffs(m->n - 2, 0.5*m->r, 1.0 + m->r, 1.0 + m->r, m->cp, m->inv);
+}
+
+struct Implicit_1D *Implicit_1D_Create(const struct Params *p)
+{
+	struct Implicit_1D *m = Work_Alloc(sizeof *m);
+	double dx = p->lx / p->nx;
+
+	m->n = p->nx;
+	m->ad = p->alpha/dx/dx;
+	m->cp = Work_Alloc(m->n*sizeof(real));
+	m->inv = Work_Alloc(m->n*sizeof(real));
+	m->d = Work_Alloc(m->n*sizeof(real));
+	Implicit_1D_Set_Dt(m, p->dt);
+	return m;
+}
+
+void Implicit_1D_Free(struct Implicit_1D *m)
+{
+	if (!m)
+		return;
+	free(m->cp);
+	free(m->inv);
+	free(m->d);
+	free(m);
+}
+
+/* ---------------------------------------------------------------- 2D */
+
+/* out[k] = (1 + r2*Ly) t along one row, k in [k0, k1), mirrored ends */
+static inline void Rhs_Y(const real *t, real *out, real r2, int k0, int k1, int ny)
+{
+	int ka = (k0 > 0) ? k0 : 1;
+	int kb = (k1 < ny) ? k1 : ny-1;
+
+	if (k0 == 0)
+		out[0] = t[0] + r2*(t[1] - t[0]);
+	for (int k = ka; k < kb; k++)
+		out[k] = t[k] + r2*(t[k-1] + t[k+1] - 2*t[k]);
+	if (k1 == ny)
+		out[ny-1] = t[ny-1] + r2*(t[ny-2] - t[ny-1]);
+}
+
+/* (1 - r2*Lx) S = (1 + r2*Ly) T on the columns [k0, k1): the lines along
+   X are the lanes k of each row, eliminated row by row */
+static void Sweep_X(const struct Implicit_2D *m, const real *T, real *S, int k0, int k1)
+{
+	int nx = m->nx;
+	int ny = m->ny;
+	real r2 = m->r2;
+
+	for (int j = 0; j < nx; j++) {
+		const real *Tj = T + (long)j*ny;
+		real *Sj = S + (long)j*ny;
+		real inv = m->ix[j];
+
+		Rhs_Y(Tj, Sj, r2, k0, k1, ny);
+		if (j == 0) {
+			for (int k = k0; k < k1; k++)
+				Sj[k] = Sj[k]*inv;
+		} else {
+			const real *Sp = Sj - ny;
+			for (int k = k0; k < k1; k++)
+				Sj[k] = (Sj[k] + r2*Sp[k])*inv;
+		}
+	}
+	for (int j = nx-2; j >= 0; j--) {
+		real *Sj = S + (long)j*ny;
+		const real *Sn = Sj + ny;
+		real cp = m->cx[j];
+		for (int k = k0; k < k1; k++)
+			Sj[k] = Sj[k] - cp*Sn[k];
+	}
+}
+
+/* (1 - r2*Ly) T = (1 + r2*Lx) S on the rows [j0, j0+nb): the rows are
+   interleaved into buf[k*ADI_LINES + w] so the Y lines become lanes */
+static void Sweep_Y(const struct Implicit_2D *m, const real *S, real *T, int j0, int nb, real *buf)
+{
+	int nx = m->nx;
+	int ny = m->ny;
+	real r2 = m->r2;
+	const real *cy = m->cy;
+	const real *iy = m->iy;
+
+	for (int w = 0; w < nb; w++) {
+		int j = j0 + w;
+		const real *Sc = S + (long)j*ny;
+		const real *Sw = (j == 0) ? Sc : Sc - ny;
+		const real *Se = (j == nx-1) ? Sc : Sc + ny;
+		for (int k = 0; k < ny; k++)
+			buf[k*ADI_LINES + w] = Sc[k] + r2*(Sw[k] + Se[k] - 2*Sc[k]);
+	}
+
+	/* all ADI_LINES lanes, the unused ones of a short block are harmless */
+	for (int w = 0; w < ADI_LINES; w++)
+		buf[w] = buf[w]*iy[0];
+	for (int k = 1; k < ny; k++) {
+		real *b = buf + k*ADI_LINES;
+		real inv = iy[k];
+		#pragma omp simd
+		for (int w = 0; w < ADI_LINES; w++)
+			b[w] = (b[w] + r2*b[w - ADI_LINES])*inv;
+	}
+	for (int k = ny-2; k >= 0; k--) {
+		real *b = buf + k*ADI_LINES;
+		real cp = cy[k];
+		#pragma omp simd
+		for (int w = 0; w < ADI_LINES; w++)
+			b[w] = b[w] - cp*b[w + ADI_LINES];
+	}
+
+	for (int w = 0; w < nb; w++) {
+		real *Tj = T + (long)(j0 + w)*ny;
+		for (int k = 0; k < ny; k++)
+			Tj[k] = buf[k*ADI_LINES + w];
+	}
+}
+
+void Implicit_2D_Diffuse(const struct Implicit_2D *m, const real *src, real *dst)
+{
+	int nx = m->nx;
+	int ny = m->ny;
+	int nthreads = omp_get_num_threads();
+
+	/* diffused tails decay into denormals, which are very slow; the
+	   advection of a split step keeps the caller's mode */
+	unsigned long fp_mode = Simd_Flush_Denormals_Save();
+
+	#pragma omp for schedule(static)
+	for (int t = 0; t < nthreads; t++) {
+		int k0 = (int)((long)ny*t/nthreads);
+		int k1 = (int)((long)ny*(t+1)/nthreads);
+		if (k0 < k1)
+			Sweep_X(m, src, m->half, k0, k1);
+	}
+
+	real *buf = m->scratch + (long)omp_get_thread_num()*ADI_LINES*ny;
+	#pragma omp for schedule(static)
+	for (int j0 = 0; j0 < nx; j0 += ADI_LINES) {
+		int nb = (nx - j0 < ADI_LINES) ? nx - j0 : ADI_LINES;
+		Sweep_Y(m, m->half, dst, j0, nb, buf);
+	}
+	Simd_Restore_Denormals(fp_mode);
+}
+
+void Implicit_2D_Set_Dt(struct Implicit_2D *m, double dt)
+{
+	double r2 = 0.5*dt*m->kd;
+
+	m->r2 = (real)r2;
+	Thomas_Coeffs(m->nx, r2, 1.0 + r2, 1.0 + 2.0*r2, m->cx, m->ix);
+	Thomas_Coeffs(m->ny, r2, 1.0 + r2, 1.0 + 2.0*r2, m->cy, m->iy);
+}
+
+void Implicit_2D_First_Touch(const struct Implicit_2D *m)
+{
+	Field_First_Touch(m->half, m->nx, m->ny);
+	Field_First_Touch(m->scratch, m->np, (long)ADI_LINES*m->ny);
+}
+
+struct Implicit_2D *Implicit_2D_Create(const struct Params *p)
+{
+	struct Implicit_2D *m = Work_Alloc(sizeof *m);
+	double dy = p->ly / p->ny;
+
+	m->nx = p->nx;
+	m->ny = p->ny;
+	m->kd = p->alpha/dy/dy;
+	m->cx = Work_Alloc(m->nx*sizeof(real));
+	m->ix = Work_Alloc(m->nx*sizeof(real));
+	m->cy = Work_Alloc(m->ny*sizeof(real));
+	m->iy = Work_Alloc(m->ny*sizeof(real));
+	m->np = p->np;
+	m->half = Field_Alloc(p, (long)m->nx*m->ny);
+	m->scratch = Field_Alloc(p, (long)p->np*ADI_LINES*m->ny);
+	if (!m->half || !m->scratch) {
+		fprintf(stderr, "allocation failed\n");
+		exit(1);
+	}
+	Implicit_2D_Set_Dt(m, p->dt);
+	return m;
+}
+
+void Implicit_2D_Free(struct Implicit_2D *m)
+{
+	if (!m)
+		return;
+	free(m->cx);
+	free(m->ix);
+	free(m->cy);
+	free(m->iy);
+	Field_Free(m->half);
+	Field_Free(m->scratch);
+	free(m);
+}
@@ -0,0 +1,66 @@
+#ifndef IMPLICIT_H
+#define IMPLICIT_H
+
+#include "solver.h"
+
+/*
+   Implicit diffusion solvers for diffusion=cn, advancing
+
+       dT/dt = alpha*Laplacian(T)
+
+   by one time step of the dt given to Set_Dt, unconditionally stable.
+   They are driven by the operator splitting in split.c, but only need
+   the Params and a field, so they can be used on their own.
+
+   1D: Crank-Nicolson on the inside cells, the wall cells held fixed as
+       in the explicit update.  One tridiagonal system per step.
+   2D: Peaceman-Rachford ADI, half an implicit step along X then along Y
+       with the mirrored (zero-gradient) walls of the explicit kernels.
+       Every grid line is its own tridiagonal system.  All lines share
+       one constant matrix, so the Thomas coefficients are worked out
+       once per dt and the sweeps run over batches of lines, one lane
+       per line: along X the lines are the contiguous k of a row, along
+       Y ADI_LINES rows are interleaved into a per-thread scratch block.
+
+   The Diffuse functions are called by every thread of a parallel
+   region.
+*/
+
+#define ADI_LINES 16
+
+struct Implicit_1D {
+	int n;
+	double ad;              /* alpha/dx^2 */
+	double r;               /* alpha*dt/dx^2 */
+	real *cp, *inv;         /* Thomas coefficients, n-2 inside cells */
+	real *d;
+};
+
+struct Implicit_2D {
+	int nx, ny;
+	int np;                 /* threads, one scratch block each */
+	double kd;              /* alpha/dy^2, as in the explicit kernel */
+	real r2;                /* dt*kd/2 */
+	real *cx, *ix;          /* Thomas coefficients along X, nx */
+	real *cy, *iy;          /* along Y, ny */
+	real *half;             /* the field after the X half-step */
+	real *scratch;          /* ADI_LINES*ny per thread */
+};
+
+struct Implicit_1D *Implicit_1D_Create(const struct Params *p);
+struct Implicit_2D *Implicit_2D_Create(const struct Params *p);
+void Implicit_1D_Set_Dt(struct Implicit_1D *m, double dt);
+void Implicit_2D_Set_Dt(struct Implicit_2D *m, double dt);
+void Implicit_1D_Free(struct Implicit_1D *m);
+void Implicit_2D_Free(struct Implicit_2D *m);
+
+/* zeroes half by rows and every thread's own scratch block; called by
+   every thread of the parallel region before the first solve */
+void Implicit_2D_First_Touch(const struct Implicit_2D *m);
+
+/* u in place */
+void Implicit_1D_Diffuse(const struct Implicit_1D *m, real *u);
+/* src -> dst, which may be the same field */
+void Implicit_2D_Diffuse(const struct Implicit_2D *m, const real *src, real *dst);
+
+#endif
@@ -0,0 +1,177 @@
+#include <omp.h>
+#include "solver.h"
+#include "riemann.h"
+#include "simd.h"
+#include "muscl.h"
+#include "split.h"
+#include "field_alloc.h"
+#include "prof.h"
+
+/* 1D flux and update loops.  The bodies are always inlined into one copy
+   per (flux scheme, grid size), see the instantiations below. */
+
+/* interfaces [1, n) split into one contiguous batch per thread; the
+   "omp for" over threads is nowait, the caller ends it with PROF_BARRIER
+   (the implicit barrier of the old loops, timed in make prof) */
+#define FOR_THREAD_BATCH(n, j0, j1)                                        \
+	int nthreads_ = omp_get_num_threads();                             \
+	_Pragma("omp for schedule(static) nowait")                         \
+	for (int t_ = 0; t_ < nthreads_; t_++)                             \
+		for (int j0 = 1 + (int)((long)((n) - 1)*t_/nthreads_),     \
+			 j1 = 1 + (int)((long)((n) - 1)*(t_+1)/nthreads_); \
+		     j0 < j1; j0 = j1)
+
+/* interfaces [j0, j1); interface j is between left = (j-1) and right = j */
+static inline __attribute__((always_inline))
+void Fluxes_1D_Batch(const struct Kernel_1D *kn, const real *u, real *F, int j0, int j1, int flux)
+{
+	double alpha_dx = kn->alpha_dx;
+	struct Riemann_Batch b = { j1 - j0, u + j0 - 1, u + j0, F + j0 };
+
+	Riemann_Batch_Body(flux, kn->a, &b);
+	if (alpha_dx != 0.0) {
+		for (int j = j0; j < j1; j++)
+			F[j] = F[j] - alpha_dx*(u[j] - u[j-1]);
+	}
+}
+
+static inline __attribute__((always_inline))
+void Fluxes_1D_Body(const struct Kernel_1D *kn, const real *u, real *F, int n, int flux)
+{
+	FOR_THREAD_BATCH(n, j0, j1) {
+		Fluxes_1D_Batch(kn, u, F, j0, j1, flux);
+	}
+	PROF_BARRIER();
+}
+
+static inline __attribute__((always_inline))
+void Update_1D_Body(const struct Kernel_1D *kn, const real *F, real *u, int n)
+{
+	double dtdx = kn->dtdx;
+
+	/*
+	Solving
+	    du/dt + dF/dx = 0
+	So
+	    U* = U - dt*dF/dx
+	With F[0]=F[1] and F[n]=F[n-1] the two wall cells never change,
+	so only the inside cells are updated.
+	*/
+	#pragma omp for nowait
+	for (int cell = 1; cell < n-1; cell++) {
+		u[cell] = u[cell] - dtdx*(F[cell+1] - F[cell]);
+	}
+	PROF_BARRIER();
+}
+
+#define KERNEL_1D(FLUX, NAME)                                                          \
+static void Fluxes_1D_##NAME(const struct Kernel_1D *kn, const real *u, real *F)       \
+{                                                                                      \
+	Fluxes_1D_Body(kn, u, F, kn->n, FLUX);                                         \
+}                                                                                      \
+static void Fluxes_1D_##NAME##_100(const struct Kernel_1D *kn, const real *u, real *F) \
+{                                                                                      \
+	Fluxes_1D_Body(kn, u, F, 100, FLUX);                                           \
+}                                                                                      \
+static void Fluxes_1D_##NAME##_200(const struct Kernel_1D *kn, const real *u, real *F) \
+{                                                                                      \
+	Fluxes_1D_Body(kn, u, F, 200, FLUX);                                           \
+}                                                                                      \
+static void Fluxes_Range_1D_##NAME(const struct Kernel_1D *kn, const real *u, real *F, \
+				   int j0, int j1)                                     \
+{                                                                                      \
+	Fluxes_1D_Batch(kn, u, F, j0, j1, FLUX);                                       \
+}
+RIEMANN_SCHEMES(KERNEL_1D)
+
+static void Update_1D(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	Update_1D_Body(kn, F, u, kn->n);
+}
+
+static void Update_1D_100(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	Update_1D_Body(kn, F, u, 100);
+}
+
+static void Update_1D_200(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	Update_1D_Body(kn, F, u, 200);
+}
+
+/* explicit SIMD flux kernel, one batch of interfaces per thread */
+static void Fluxes_1D_Simd(const struct Kernel_1D *kn, const real *u, real *F)
+{
+	Simd_Flush_Denormals();
+	FOR_THREAD_BATCH(kn->n, j0, j1) {
+		kn->simd->fluxes_1d(kn->flux, kn->a, (real)kn->alpha_dx, u, F, j0, j1);
+	}
+	PROF_BARRIER();
+}
+
+static void Fluxes_Range_1D_Simd(const struct Kernel_1D *kn, const real *u, real *F, int j0, int j1)
+{
+	kn->simd->fluxes_1d(kn->flux, kn->a, (real)kn->alpha_dx, u, F, j0, j1);
+}
+
+/* [flux][size]: generic, 100, 200 */
+#define KERNEL_1D_ENTRY(FLUX, NAME) \
+	[FLUX] = { Fluxes_1D_##NAME, Fluxes_1D_##NAME##_100, Fluxes_1D_##NAME##_200 },
+static const Fluxes_1D_Fn fluxes_1d[NUM_FLUX_SCHEMES][3] = {
+	RIEMANN_SCHEMES(KERNEL_1D_ENTRY)
+};
+
+static const Update_1D_Fn update_1d[3] = { Update_1D, Update_1D_100, Update_1D_200 };
+
+#define KERNEL_1D_RANGE_ENTRY(FLUX, NAME) [FLUX] = Fluxes_Range_1D_##NAME,
+static const Fluxes_Range_1D_Fn fluxes_range_1d[NUM_FLUX_SCHEMES] = {
+	RIEMANN_SCHEMES(KERNEL_1D_RANGE_ENTRY)
+};
+
+void Kernel_1D_Set_Dt(struct Kernel_1D *k, const struct Params *p, double dt)
+{
+	k->dtdx = dt / (p->lx / p->nx);
+	if (k->split)
+		Split_1D_Set_Dt(k->split, dt);
+}
+
+void Kernel_1D_Init(struct Kernel_1D *k, const struct Params *p)
+{
+	double dx = p->lx / p->nx;
+
+	k->n = p->nx;
+	k->a = (real)p->u;
+	k->alpha_dx = p->alpha / dx;
+	k->split = NULL;
+	Kernel_1D_Set_Dt(k, p, p->dt);
+
+	int size = 0;
+	if (p->nx == 100)
+		size = 1;
+	else if (p->nx == 200)
+		size = 2;
+	k->fluxes = fluxes_1d[p->flux][size];
+	k->update = update_1d[size];
+	k->fluxes_range = fluxes_range_1d[p->flux];
+	k->own_fluxes = 0;
+	k->flux = p->flux;
+	k->simd = Simd_Get(p->simd);
+	if (k->simd) {
+		k->fluxes = Fluxes_1D_Simd;
+		k->fluxes_range = Fluxes_Range_1D_Simd;
+	}
+	k->sync = p->slab ? Slab_Create(p) : NULL;
+	k->stage = k->stage_flux = NULL;
+	if (p->limiter != LIMITER_NONE || p->rk > 1)
+		Muscl_1D_Init(k, p);
+	if (p->diffusion != DIFFUSION_EXPLICIT)
+		Split_1D_Init(k, p);
+}
+
+void Kernel_1D_Free(struct Kernel_1D *k)
+{
+	Field_Free(k->stage);
+	Field_Free(k->stage_flux);
+	Split_1D_Free(k->split);
+	Slab_Free(k->sync);
+}
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include "solver.h"
+#include "riemann.h"
+#include "simd.h"
+#include "muscl.h"
+#include "split.h"
+#include "field_alloc.h"
+#include "prof.h"
+#include "sched.h"
+
+/* new value of one cell from its centre C, its 4 neighbours (already
+   mirrored on the walls) and the 4 interface fluxes around it */
+static inline __attribute__((always_inline))
+real Cell_Update(double kd, double dtdx, double dtdy, double dt,
+		 real C, real Left, real Right, real Bottom, real Top,
+		 real Fl, real Fr, real Wb, real Wt)
+{
+	real D = kd*(Left+Right+Top+Bottom-4*C);
+	return C - (dtdx*(Fr - Fl)) - (dtdy*(Wt - Wb)) + dt*D;
+}
+
+/*
+   One row j of the fused step over the cells [ka, ka+cnt): Tc, Tw and Te
+   are the source rows j, j-1 and j+1 (Tw = Tc on the left wall, Te = Tc
+   on the right wall) and Tn the destination row, all pointing at column
+   ka.  On the walls dF/dx = 0 and dW/dy = 0 (F[0]=F[1], F[NX]=F[NX-1],
+   same for W), and the diffusion term mirrors the boundary cell.
+*/
+static inline __attribute__((always_inline))
+void Step_2D_Row(const struct Kernel_2D *kn, int flux,
+		 const real *Tc, const real *Tw, const real *Te, real *Tn,
+		 int west_wall, int east_wall, int bottom_wall, int top_wall, int cnt)
+{
+	real u = kn->u;
+	real v = kn->v;
+	real su = kn->su;
+	real sv = kn->sv;
+	double kd = kn->kd;
+	double dtdx = kn->dtdx;
+	double dtdy = kn->dtdy;
+	double dt = kn->dt;
+
+	/* cells on the left/right walls see the same flux on both sides */
+	const real *FlL = west_wall ? Tc : Tw;
+	const real *FlR = west_wall ? Te : Tc;
+	const real *FrL = east_wall ? Tw : Tc;
+	const real *FrR = east_wall ? Tc : Te;
+
+	real Wb, Wt;
+	int k0 = 0;
+	int k1 = cnt;
+
+	if (bottom_wall) {
+		Wt = Riemann_Flux_Speed(flux, v, sv, Tc[0], Tc[1]);
+		Tn[0] = Cell_Update(kd, dtdx, dtdy, dt, Tc[0], Tw[0], Te[0], Tc[0], Tc[1],
+				Riemann_Flux_Speed(flux, u, su, FlL[0], FlR[0]),
+				Riemann_Flux_Speed(flux, u, su, FrL[0], FrR[0]), Wt, Wt);
+		k0 = 1;
+	}
+	if (top_wall)
+		k1 = cnt-1;
+
+	for (int k = k0; k < k1; k++) {
+		Wb = Riemann_Flux_Speed(flux, v, sv, Tc[k-1], Tc[k]);
+		Wt = Riemann_Flux_Speed(flux, v, sv, Tc[k], Tc[k+1]);
+		Tn[k] = Cell_Update(kd, dtdx, dtdy, dt, Tc[k], Tw[k], Te[k], Tc[k-1], Tc[k+1],
+				Riemann_Flux_Speed(flux, u, su, FlL[k], FlR[k]),
+				Riemann_Flux_Speed(flux, u, su, FrL[k], FrR[k]), Wb, Wt);
+	}
+
+	if (top_wall) {
+		int k = cnt-1;
+		Wb = Riemann_Flux_Speed(flux, v, sv, Tc[k-1], Tc[k]);
+		Tn[k] = Cell_Update(kd, dtdx, dtdy, dt, Tc[k], Tw[k], Te[k], Tc[k-1], Tc[k],
+				Riemann_Flux_Speed(flux, u, su, FlL[k], FlR[k]),
+				Riemann_Flux_Speed(flux, u, su, FrL[k], FrR[k]), Wb, Wb);
+	}
+}
+
+static inline __attribute__((always_inline))
+void Step_2D_Body(const struct Kernel_2D *kn, const real *T, real *Tnew, int nx, int ny, int flux)
+{
+    /*
+    Fused flux + update, one pass over the grid:
+        Tnew = T - dt*dF/dx - dt*dW/dy + dt*D
+    The X flux F, the Y flux W and the diffusion term D are formed in
+    registers and only Tnew is written.
+    */
+	#pragma omp for nowait
+	for (int j = 0; j < nx; j++) {
+		const real *Tc = T + (long)j*ny;
+		const real *Tw = (j == 0) ? Tc : Tc - ny;
+		const real *Te = (j == (nx-1)) ? Tc : Tc + ny;
+
+		Step_2D_Row(kn, flux, Tc, Tw, Te, Tnew + (long)j*ny,
+			    j == 0, j == (nx-1), 1, 1, ny);
+	}
+	PROF_BARRIER();
+}
+
+/* Same step on the rectangle [ja,jb) x [ka,kb) only, read from src and
+   written to dst.  Serial: the caller hands out the rectangles. */
+static inline __attribute__((always_inline))
+void Region_2D_Body(const struct Kernel_2D *kn, const struct Grid_View *src, const struct Grid_View *dst,
+		    int ja, int jb, int ka, int kb, int flux)
+{
+	int nx = kn->nx;
+	int ny = kn->ny;
+
+	for (int j = ja; j < jb; j++) {
+		const real *Tc = src->data + (long)(j - src->oj)*src->stride + (ka - src->ok);
+		const real *Tw = (j == 0) ? Tc : Tc - src->stride;
+		const real *Te = (j == (nx-1)) ? Tc : Tc + src->stride;
+		real *Tn = dst->data + (long)(j - dst->oj)*dst->stride + (ka - dst->ok);
+
+		Step_2D_Row(kn, flux, Tc, Tw, Te, Tn,
+			    j == 0, j == (nx-1), ka == 0, kb == ny, kb - ka);
+	}
+}
+
+#define KERNEL_2D(FLUX, NAME)                                                           \
+static void Step_2D_##NAME(const struct Kernel_2D *kn, const real *T, real *Tnew)       \
+{                                                                                       \
+	Step_2D_Body(kn, T, Tnew, kn->nx, kn->ny, FLUX);                                \
+}                                                                                       \
+static void Step_2D_##NAME##_200(const struct Kernel_2D *kn, const real *T, real *Tnew) \
+{                                                                                       \
+	Step_2D_Body(kn, T, Tnew, 200, 200, FLUX);                                      \
+}                                                                                       \
+static void Step_2D_##NAME##_400(const struct Kernel_2D *kn, const real *T, real *Tnew) \
+{                                                                                       \
+	Step_2D_Body(kn, T, Tnew, 400, 400, FLUX);                                      \
+}                                                                                       \
+static void Step_2D_##NAME##_800(const struct Kernel_2D *kn, const real *T, real *Tnew) \
+{                                                                                       \
+	Step_2D_Body(kn, T, Tnew, 800, 800, FLUX);                                      \
+}                                                                                       \
+static void Region_2D_##NAME(const struct Kernel_2D *kn, const struct Grid_View *src,   \
+			     const struct Grid_View *dst, int ja, int jb, int ka, int kb)     \
+{                                                                                       \
+	Region_2D_Body(kn, src, dst, ja, jb, ka, kb, FLUX);                             \
+}
+RIEMANN_SCHEMES(KERNEL_2D)
+
+/* the same two entry points on top of the explicit SIMD row kernel */
+static void Step_2D_Simd(const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	int nx = kn->nx;
+	int ny = kn->ny;
+
+	Simd_Flush_Denormals();
+	#pragma omp for nowait
+	for (int j = 0; j < nx; j++) {
+		const real *Tc = T + (long)j*ny;
+		const real *Tw = (j == 0) ? Tc : Tc - ny;
+		const real *Te = (j == (nx-1)) ? Tc : Tc + ny;
+
+		kn->simd->row_2d(&kn->c, kn->flux, Tc, Tw, Te, Tnew + (long)j*ny,
+				 j == 0, j == (nx-1), 1, 1, ny);
+	}
+	PROF_BARRIER();
+}
+
+/* the step over the scheduler's tiles (steal=1), on top of either region
+   kernel: bitwise the same as the row sweeps */
+static void Step_2D_Steal(const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	struct Tile_Sched *s = kn->sched;
+	struct Grid_View in = { (real*)T, 0, 0, kn->ny };
+	struct Grid_View out = { Tnew, 0, 0, kn->ny };
+
+	Sched_Start(s, s->ntiles);
+	for (int t; (t = Sched_Next(s)) >= 0; ) {
+		int j0, j1, k0, k1;
+		Sched_Tile(s, t, &j0, &j1, &k0, &k1);
+		kn->region(kn, &in, &out, j0, j1, k0, k1);
+	}
+	PROF_BARRIER();
+}
+
+static void Region_2D_Simd(const struct Kernel_2D *kn, const struct Grid_View *src, const struct Grid_View *dst,
+			   int ja, int jb, int ka, int kb)
+{
+	int nx = kn->nx;
+	int ny = kn->ny;
+
+	Simd_Flush_Denormals();
+	for (int j = ja; j < jb; j++) {
+		const real *Tc = src->data + (long)(j - src->oj)*src->stride + (ka - src->ok);
+		const real *Tw = (j == 0) ? Tc : Tc - src->stride;
+		const real *Te = (j == (nx-1)) ? Tc : Tc + src->stride;
+		real *Tn = dst->data + (long)(j - dst->oj)*dst->stride + (ka - dst->ok);
+
+		kn->simd->row_2d(&kn->c, kn->flux, Tc, Tw, Te, Tn,
+				 j == 0, j == (nx-1), ka == 0, kb == ny, kb - ka);
+	}
+}
+
+/* [flux][size]: generic, 200x200, 400x400, 800x800 */
+#define STEP_2D_ENTRY(FLUX, NAME) \
+	[FLUX] = { Step_2D_##NAME, Step_2D_##NAME##_200, Step_2D_##NAME##_400, Step_2D_##NAME##_800 },
+static const Step_2D_Fn step_2d[NUM_FLUX_SCHEMES][4] = {
+	RIEMANN_SCHEMES(STEP_2D_ENTRY)
+};
+
+#define REGION_2D_ENTRY(FLUX, NAME) [FLUX] = Region_2D_##NAME,
+static const Region_2D_Fn region_2d[NUM_FLUX_SCHEMES] = {
+	RIEMANN_SCHEMES(REGION_2D_ENTRY)
+};
+
+void Kernel_2D_Set_Dt(struct Kernel_2D *k, const struct Params *p, double dt)
+{
+	k->dtdx = dt/(p->lx / p->nx);
+	k->dtdy = dt/(p->ly / p->ny);
+	k->dt = dt;
+	k->c.dtdx = (real)k->dtdx;
+	k->c.dtdy = (real)k->dtdy;
+	k->c.dt = (real)k->dt;
+	if (k->split)
+		Split_2D_Set_Dt(k->split, dt);
+}
+
+void Kernel_2D_Init(struct Kernel_2D *k, const struct Params *p)
+{
+	double dy = p->ly / p->ny;
+
+	k->nx = p->nx;
+	k->ny = p->ny;
+	k->u = (real)p->u;
+	k->v = (real)p->v;
+	k->su = (k->u < 0) ? -k->u : k->u;
+	k->sv = (k->v < 0) ? -k->v : k->v;
+	if (p->flux == FLUX_RUSANOV && p->rusanov_speed > 0.0)
+		k->su = k->sv = (real)p->rusanov_speed;
+	k->kd = p->alpha/dy/dy;
+	k->split = NULL;
+
+	int size = 0;
+	if (p->nx == p->ny) {
+		if (p->nx == 200)
+			size = 1;
+		else if (p->nx == 400)
+			size = 2;
+		else if (p->nx == 800)
+			size = 3;
+	}
+	k->step = step_2d[p->flux][size];
+	k->region = region_2d[p->flux];
+
+	k->flux = p->flux;
+	k->c.u = k->u;
+	k->c.v = k->v;
+	k->c.su = k->su;
+	k->c.sv = k->sv;
+	k->c.kd = (real)k->kd;
+	Kernel_2D_Set_Dt(k, p, p->dt);
+	k->simd = Simd_Get(p->simd);
+	if (k->simd) {
+		k->step = Step_2D_Simd;
+		k->region = Region_2D_Simd;
+	}
+	k->sched = NULL;
+	if (p->steal) {
+		k->sched = Sched_Create(p);
+		k->step = Step_2D_Steal;
+	}
+	k->stage = k->scratch = NULL;
+	if (p->limiter != LIMITER_NONE || p->rk > 1)
+		Muscl_2D_Init(k, p);
+	if (p->diffusion != DIFFUSION_EXPLICIT)
+		Split_2D_Init(k, p);
+}
+
+void Kernel_2D_First_Touch(const struct Kernel_2D *k)
+{
+	if (k->stage)
+		Field_First_Touch(k->stage, k->nx, k->ny);
+	if (k->split)
+		Split_2D_First_Touch(k);
+}
+
+void Kernel_2D_Free(struct Kernel_2D *k)
+{
+	Field_Free(k->stage);
+	free(k->scratch);
+	Split_2D_Free(k->split);
+	Sched_Free(k->sched);
+}
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "params.h"
+#include "solver.h"
+#include "riemann.h"
+#include "field_alloc.h"
+
+/*
+   Throughput of the solver kernels in isolation, against a roofline
+   measured on the same machine:
+
+       ./kernel_bench [sizes_1d=...] [sizes_2d=...] [threads=...]
+                      [kernels=...] [min_time=s] [key=value ...]
+
+   Every kernel of the table below runs on the pulse of the solver over
+   each grid size and thread count (comma lists; threads defaults to the
+   powers of two up to the OpenMP maximum), repeated until it takes at
+   least min_time seconds.  The other key=value arguments set the solver
+   parameters as for ./main (flux, alpha, simd, ...); dt follows from
+   cfl = 0.4 on every grid unless given.  make kernel_bench builds the
+   float and the double version (kernel_bench_double).
+
+   Per kernel, size and thread count the table holds the cell updates
+   per second, the bandwidth of the compulsory traffic (every array read
+   or written once per sweep, no write-allocate, like STREAM), the
+   useful arithmetic intensity and the roofline bound: min(peak flop/s,
+   intensity x triad bandwidth), with the bandwidth of a STREAM triad on
+   arrays of the same size, so small grids are held against the cache
+   they fit in and large ones against memory.  The triad pays for the
+   write-allocate of its output, an in-place kernel such as update_1d
+   does not, and can pass 100%.
+
+   A kernel is one line of the benches[] table: its dimension, the reals
+   it moves per cell, its flop count and a function that every thread
+   of the parallel region runs.
+*/
+
+struct Bench_State {
+	struct Params p;
+	struct Kernel_1D k1;
+	struct Kernel_2D k2;
+	long n;                 /* cells */
+	real *a, *b, *c;
+};
+
+typedef void (*Bench_Fn)(struct Bench_State *s, int reps);
+
+struct Bench {
+	const char *name;
+	int dim;
+	double reals;                   /* reals moved per cell and sweep */
+	double (*flops)(const struct Params *p);        /* per cell */
+	Bench_Fn run;                   /* every thread of the parallel region */
+};
+
+/* useful flops per interface of each scheme: the multiplies, adds and
+   subtracts of riemann.h (HLL takes its upwind branch) */
+static double Flux_Flops(int flux)
+{
+	switch (flux) {
+	case FLUX_UPWIND:
+	case FLUX_HLL:
+		return 1;
+	case FLUX_CENTRAL:
+		return 4;
+	default:
+		return 7;
+	}
+}
+
+static double Fluxes_1D_Flops(const struct Params *p)
+{
+	return Flux_Flops(p->flux) + (p->alpha != 0.0 ? 3 : 0);
+}
+
+static double Update_1D_Flops(const struct Params *p)
+{
+	(void)p;
+	return 3;
+}
+
+/* Cell_Update and a cell's share of the fluxes, one per interface: the
+   fused step recomputes the x fluxes of both faces, which counts as lost
+   time rather than as flops */
+static double Step_2D_Flops(const struct Params *p)
+{
+	return 2*Flux_Flops(p->flux) + 14;
+}
+
+/* the flux kernel itself, also for a strang split kernel whose step
+   leaves it to the update (own_fluxes) */
+static void Run_Fluxes_1D(struct Bench_State *s, int reps)
+{
+	for (int r = 0; r < reps; r++)
+		s->k1.fluxes(&s->k1, s->a, s->b);
+}
+
+static void Run_Update_1D(struct Bench_State *s, int reps)
+{
+	for (int r = 0; r < reps; r++)
+		Update_State_1D(&s->k1, s->b, s->a);
+}
+
+static void Run_Step_2D(struct Bench_State *s, int reps)
+{
+	real *T = s->a;
+	real *Tnew = s->b;
+
+	for (int r = 0; r < reps; r++) {
+		Compute_Step_2D(&s->k2, T, Tnew);
+		real *tmp = T;
+		T = Tnew;
+		Tnew = tmp;
+	}
+}
+
+/* a = b + 0.5 c over the grid's cells */
+static void Run_Triad(struct Bench_State *s, int reps)
+{
+	real *a = s->a, *b = s->b, *c = s->c;
+	real q = 0.5;
+
+	for (int r = 0; r < reps; r++) {
+		#pragma omp for schedule(static)
+		for (long i = 0; i < s->n; i++)
+			a[i] = b[i] + q*c[i];
+	}
+}
+
+static const struct Bench benches[] = {
+	{ "fluxes_1d", 1, 2, Fluxes_1D_Flops, Run_Fluxes_1D },
+	{ "update_1d", 1, 3, Update_1D_Flops, Run_Update_1D },
+	{ "step_2d",   2, 2, Step_2D_Flops,   Run_Step_2D },
+};
+
+#define NUM_BENCHES (int)(sizeof(benches) / sizeof(benches[0]))
+
+/* seconds per repeat of fn on the given threads, doubling the repeats
+   until the whole run takes min_time */
+static double Time_Reps(Bench_Fn fn, struct Bench_State *s, int threads, double min_time)
+{
+	for (int reps = 1; ; reps *= 2) {
+		double t0 = omp_get_wtime();
+		#pragma omp parallel num_threads(threads)
+		fn(s, reps);
+		double t = omp_get_wtime() - t0;
+		if (t >= min_time || reps >= (1 << 30))
+			return t / reps;
+	}
+}
+
+/* flop/s of independent multiply and add streams held in registers
+   (16 SSE registers' worth), the compute roof of this build: no FMA
+   with -ffp-contract=off, and no wider vectors without -march */
+#define PEAK_LANES (128 / (int)sizeof(real))
+#define PEAK_CHAIN 4
+
+static void Run_Peak(struct Bench_State *s, int reps)
+{
+	real x[PEAK_LANES], y[PEAK_LANES];
+	real m = 1.001, d = 1/1.001, c = 0.001;
+	(void)s;
+
+	for (int i = 0; i < PEAK_LANES; i++)
+		x[i] = y[i] = (real)i / PEAK_LANES;
+	for (int r = 0; r < reps; r++) {
+		for (int k = 0; k < PEAK_CHAIN; k++) {
+			#pragma omp simd
+			for (int i = 0; i < PEAK_LANES; i++) {
+				x[i] = x[i]*m;
+				y[i] = y[i] + c;
+			}
+			#pragma omp simd
+			for (int i = 0; i < PEAK_LANES; i++) {
+				x[i] = x[i]*d;
+				y[i] = y[i] - c;
+			}
+		}
+		__asm__ __volatile__("" : "+m"(x), "+m"(y));
+	}
+}
+
+/* the best of three, the first one warms up the cores */
+static double Peak_Flops(int threads, double min_time)
+{
+	struct Bench_State s;
+	double best = 0.0;
+
+	for (int i = 0; i < 3; i++) {
+		double f = 4.0*PEAK_CHAIN*PEAK_LANES*threads / Time_Reps(Run_Peak, &s, threads, min_time);
+		if (f > best)
+			best = f;
+	}
+	return best;
+}
+
+/* comma list of positive ints into list[max]; the count, 0 if malformed */
+static int Parse_Ints(const char *s, int *list, int max)
+{
+	int count = 0;
+	char *end;
+
+	while (*s && count < max) {
+		long v = strtol(s, &end, 10);
+		if (end == s || v < 1)
+			return 0;
+		list[count++] = (int)v;
+		s = *end == ',' ? end + 1 : end;
+	}
+	return *s ? 0 : count;
+}
+
+/* the grid of bench b at size n, its kernel and arrays, first touched
+   by the threads that use them */
+static int Setup(struct Bench_State *s, const struct Params *base, const struct Bench *b, int n)
+{
+	s->p = *base;
+	s->p.dim = b->dim;
+	s->p.nx = n;
+	s->p.ny = n;
+	if (Params_Check(&s->p) != 0)
+		return -1;
+	s->n = (long)s->p.nx*s->p.ny;
+	s->a = Field_Alloc(&s->p, s->n + 1);
+	s->b = Field_Alloc(&s->p, s->n + 1);
+	s->c = Field_Alloc(&s->p, s->n + 1);
+	if (!s->a || !s->b || !s->c) {
+		fprintf(stderr, "allocation failed\n");
+		return -1;
+	}
+	if (b->dim == 1)
+		Kernel_1D_Init(&s->k1, &s->p);
+	else
+		Kernel_2D_Init(&s->k2, &s->p);
+
+	#pragma omp parallel
+	{
+	Initial_Condition(&s->p, s->a);
+	Field_First_Touch(s->b, s->p.nx, s->p.ny);
+	Field_First_Touch(s->c, s->p.nx, s->p.ny);
+	if (b->dim == 2)
+		Kernel_2D_First_Touch(&s->k2);
+	}
+	s->a[s->n] = s->b[s->n] = s->c[s->n] = 0;
+	return 0;
+}
+
+static void Teardown(struct Bench_State *s, const struct Bench *b)
+{
+	if (b->dim == 1)
+		Kernel_1D_Free(&s->k1);
+	else
+		Kernel_2D_Free(&s->k2);
+	Field_Free(s->a);
+	Field_Free(s->b);
+	Field_Free(s->c);
+}
+
+#define MAX_LIST 32
+
+int main(int argc, char **argv)
+{
+	struct Params p;
+	int sizes_1d[MAX_LIST] = { 1000, 100000, 10000000 };
+	int sizes_2d[MAX_LIST] = { 100, 1000, 3000 };
+	int threads[MAX_LIST];
+	int n1 = 3, n2 = 3, nt = 0;
+	const char *kernels = "";
+	double min_time = 0.2;
+	char **rest = Work_Alloc((argc + 1)*sizeof(char*));
+	int nrest = 1;
+
+	Params_Default(&p);
+	p.dt = 0.0;
+	p.cfl = 0.4;
+	p.debug = 0;
+	rest[0] = argv[0];
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		int ok = 1;
+		if (!strncmp(arg, "sizes_1d=", 9))
+			ok = (n1 = Parse_Ints(arg + 9, sizes_1d, MAX_LIST)) > 0;
+		else if (!strncmp(arg, "sizes_2d=", 9))
+			ok = (n2 = Parse_Ints(arg + 9, sizes_2d, MAX_LIST)) > 0;
+		else if (!strncmp(arg, "threads=", 8))
+			ok = (nt = Parse_Ints(arg + 8, threads, MAX_LIST)) > 0;
+		else if (!strncmp(arg, "kernels=", 8))
+			kernels = arg + 8;
+		else if (!strncmp(arg, "min_time=", 9))
+			ok = (min_time = atof(arg + 9)) > 0.0;
+		else
+			rest[nrest++] = argv[i];
+		if (!ok) {
+			fprintf(stderr, "bad argument %s\n", arg);
+			return 1;
+		}
+	}
+	if (Params_Parse_Args(&p, nrest, rest) != 0) {
+		fprintf(stderr, "usage: %s [sizes_1d=n,..] [sizes_2d=n,..] [threads=t,..] "
+			"[kernels=name,..] [min_time=s] [key=value] ...\n", argv[0]);
+		return 1;
+	}
+	if (!nt) {
+		int max = omp_get_max_threads();
+		for (int t = 1; t < max && nt < MAX_LIST - 1; t *= 2)
+			threads[nt++] = t;
+		threads[nt++] = max;
+	}
+
+	printf("%s precision, flux %s, alpha %g, min_time %g s\n",
+	       sizeof(real) == 4 ? "float" : "double", Flux_Name(p.flux), p.alpha, min_time);
+	double peak[MAX_LIST];
+	printf("peak:");
+	for (int t = 0; t < nt; t++) {
+		peak[t] = Peak_Flops(threads[t], min_time);
+		printf("  %d threads %.3g GFlop/s", threads[t], peak[t]/1e9);
+	}
+	printf("\n\n");
+
+	printf("%-10s %9s %4s %10s %9s %7s %9s %9s %10s %6s\n", "kernel", "size", "thr",
+	       "Mcell/s", "GB/s", "flop/B", "GFlop/s", "triad", "bound", "%bound");
+	for (int k = 0; k < NUM_BENCHES; k++) {
+		const struct Bench *b = &benches[k];
+		const int *sizes = b->dim == 1 ? sizes_1d : sizes_2d;
+		int nsizes = b->dim == 1 ? n1 : n2;
+
+		if (kernels[0] && !strstr(kernels, b->name))
+			continue;
+		for (int i = 0; i < nsizes; i++) {
+			struct Bench_State s;
+			if (Setup(&s, &p, b, sizes[i]) != 0)
+				return 1;
+			double flops = b->flops(&s.p);
+			double bytes = b->reals*sizeof(real);
+			double intensity = flops / bytes;
+
+			for (int t = 0; t < nt; t++) {
+				double triad = 3.0*sizeof(real)*s.n / Time_Reps(Run_Triad, &s, threads[t], min_time);
+				double rate = s.n / Time_Reps(b->run, &s, threads[t], min_time);
+				double roof = intensity*triad < peak[t] ? intensity*triad : peak[t];
+				double bound = roof / flops;
+
+				printf("%-10s %9d %4d %10.1f %9.2f %7.3f %9.2f %9.2f %10.1f %6.1f\n",
+				       b->name, sizes[i], threads[t], rate/1e6, rate*bytes/1e9, intensity,
+				       rate*flops/1e9, triad/1e9, bound/1e6, 100.0*rate/bound);
+			}
+			Teardown(&s, b);
+		}
+	}
+	free(rest);
+	return 0;
+}
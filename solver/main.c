@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <omp.h>
+#include "params.h"
+#include "solver.h"
+#include "field_io.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "field_alloc.h"
+#include "adaptive.h"
+#include "split.h"
+#include "amr.h"
+#include "active.h"
+#include "ensemble.h"
+#include "telemetry.h"
+#include "sched.h"
+#include "prof.h"
+
+/* With restart=<file> the field, step and time come from a checkpoint;
+   saved is NULL on a fresh start, exits on a bad checkpoint. */
+static real *Load_Restart(const struct Params *p, long n, int *step, real *time)
+{
+	*step = 0;
+	*time = 0.0;
+	if (!p->restart[0])
+		return NULL;
+
+	real *saved = (real*)malloc(n*sizeof(real));
+	if (!saved) {
+		fprintf(stderr, "allocation failed\n");
+		exit(1);
+	}
+	if (Checkpoint_Read(p, saved, n, step, time) != 0)
+		exit(1);
+	if (p->debug) printf("Restarting from %s at step %d\n", p->restart, *step);
+	return saved;
+}
+
+/* inside the parallel region: the initial condition or the restart state,
+   either way first touched row by row by the threads that work on it */
+static void Start_Field(const struct Params *p, real *T, const real *saved)
+{
+	if (!saved) {
+		Initial_Condition(p, T);
+		return;
+	}
+	#pragma omp for schedule(static)
+	for (int j = 0; j < p->nx; j++) {
+		for (int k = 0; k < p->ny; k++)
+			T[(long)j*p->ny + k] = saved[(long)j*p->ny + k];
+	}
+}
+
+/* the error norms against the analytic solution, from the mean square
+   error: L1 the mean |e|, L2 the rms */
+static void Print_Errors(double l1, double mse, double linf)
+{
+	printf("Errors L1 %g L2 %g Linf %g\n", l1, sqrt(mse), linf);
+}
+
+/* 1D output: results.fld holds u and F, or the old text files */
+static void Write_Output_1D(const struct Params *p, const real *u, const real *F, int nsteps, double time)
+{
+	int n = p->nx;
+	int nif = n + 1;
+	double dx = p->lx / n;
+
+	if (p->output == OUTPUT_BINARY) {
+		struct Field_Var vars[] = { { "u", u, n }, { "F", F, nif } };
+		double t0 = omp_get_wtime();
+		if (Field_Write("results.fld", p, nsteps, time, 2, vars) == 0 && p->debug)
+			printf("Wrote results.fld in %g s\n", omp_get_wtime() - t0);
+		return;
+	}
+
+	/* write fluxes to file: one line per interface (index, flux) */
+	FILE *fp = fopen("fluxes.dat", "w");
+	for (int j = 0; j < nif; ++j) {
+		fprintf(fp, "%d %.15e\n", j, F[j]);
+	}
+	fclose(fp);
+
+	// Write U to file now
+	fp = fopen("results.dat", "w");
+	for (int cell = 0; cell < n; cell++) {
+		double x = (cell+0.5)*dx;
+		fprintf(fp, "%g\t%g\n", x, u[cell]);
+	}
+	fclose(fp);
+}
+
+/* 2D output: resultsT.fld holds T, or the old resultsT.txt */
+static void Write_Output_2D(const struct Params *p, const real *T, int nsteps, double time)
+{
+	int nx = p->nx;
+	int ny = p->ny;
+	double dx = p->lx / nx;
+	double dy = p->ly / ny;
+
+	if (p->output == OUTPUT_BINARY) {
+		struct Field_Var vars[] = { { "T", T, (long)nx*ny } };
+		double t0 = omp_get_wtime();
+		if (Field_Write("resultsT.fld", p, nsteps, time, 1, vars) == 0 && p->debug)
+			printf("Wrote resultsT.fld in %g s\n", omp_get_wtime() - t0);
+		return;
+	}
+
+	if (p->debug) printf("Saving T results\n");
+	FILE *pFile = fopen("resultsT.txt", "w");
+	for (int i = 0; i < nx; i++) {
+		for (int j = 0; j < ny; j++) {
+			float X = (i+0.5)*dx;
+			float Y = (j+0.5)*dy;
+			fprintf(pFile, "%g\t%g\t%g\n", X, Y, T[(long)i*ny+j]);
+		}
+	}
+	fclose(pFile);
+}
+
+static int Run_1D(const struct Params *p)
+{
+	int n = p->nx;
+	int nif = n + 1;
+	real *u = Field_Alloc(p, n);
+	real *F = Field_Alloc(p, nif);
+	real *A = Field_Alloc(p, n);
+
+	if (!u || !F || !A) {
+		fprintf(stderr, "allocation failed\n");
+		return 1;
+	}
+
+	struct Kernel_1D kn;
+	Kernel_1D_Init(&kn, p);
+
+	struct Snapshot_Writer snap, chk;
+	if (Snapshot_Init(&snap, p, "u", n) != 0 || Checkpoint_Init(&chk, p, "u", n) != 0)
+		return 1;
+
+	int start_step;
+	real start_time;
+	real *saved = Load_Restart(p, n, &start_step, &start_time);
+
+	int nsteps = p->adaptive ? 0 : Count_Timesteps(p);
+	struct Telemetry tm;
+	if (Telemetry_Start(&tm, p, start_step, nsteps) != 0)
+		return 1;
+
+	double t_start = 0.0, t_end = 0.0;
+	real Total_error = 0.0;
+	double L1 = 0.0, Linf = 0.0;
+	omp_set_num_threads(p->np);
+	PROF_INIT(p);
+	#pragma omp parallel
+	{
+	PROF_THREAD_START();
+	Pin_Threads(p);
+	Start_Field(p, u, saved);
+	Analytic_Solution(p, A);
+	Field_First_Touch(F, nif, 1);
+
+	#pragma omp barrier
+	#pragma omp master
+	t_start = omp_get_wtime();
+
+	if (p->adaptive) {
+		PROF_BEGIN(PROF_STEP);
+		int steps = Advance_Adaptive_1D(&kn, p, u, F, &snap, &tm);
+		PROF_END(PROF_STEP);
+		#pragma omp master
+		nsteps = steps;
+	} else if (p->slab) {
+		/* run from one snapshot or checkpoint to the next */
+		real time = start_time;
+		for (int step = start_step; step < nsteps; ) {
+			int next = Snapshot_Next(&snap, step, nsteps);
+			int next_chk = Snapshot_Next(&chk, step, nsteps);
+			if (next_chk < next)
+				next = next_chk;
+
+			Advance_Slab_1D(&kn, p, u, F, step, next, &tm);
+			for (; step < next; step++)
+				time = time + p->dt;
+
+			PROF_BEGIN(PROF_SNAPSHOT);
+			if (Snapshot_Due(&snap, step))
+				Snapshot_Take(&snap, u, step, time);
+			if (step < nsteps && Snapshot_Due(&chk, step))
+				Snapshot_Take(&chk, u, step, time);
+			PROF_END(PROF_SNAPSHOT);
+		}
+	} else {
+		real time = start_time;
+		for (int timestep = start_step; timestep < p->max_timesteps; timestep++) {
+
+			// Compute fluxes
+			PROF_BEGIN(PROF_FLUXES);
+			Compute_Fluxes_1D(&kn, u, F);
+			PROF_END(PROF_FLUXES);
+
+			// Update U using Fluxes F
+			PROF_BEGIN(PROF_UPDATE);
+			Update_State_1D(&kn, F, u);
+			PROF_END(PROF_UPDATE);
+
+			time = time + p->dt;
+			#pragma omp master
+			Telemetry_Push(&tm, timestep + 1, time, (double)n*(timestep + 1 - start_step));
+			if (Snapshot_Due(&snap, timestep + 1)) {
+				PROF_BEGIN(PROF_SNAPSHOT);
+				Snapshot_Take(&snap, u, timestep + 1, time);
+				PROF_END(PROF_SNAPSHOT);
+			}
+
+			if (time > p->t_final) {
+				break;
+			}
+
+			/* after the exit test: a restart always has steps left to do */
+			if (Snapshot_Due(&chk, timestep + 1)) {
+				PROF_BEGIN(PROF_SNAPSHOT);
+				Snapshot_Take(&chk, u, timestep + 1, time);
+				PROF_END(PROF_SNAPSHOT);
+			}
+		}
+	}
+
+	#pragma omp barrier
+	#pragma omp master
+	t_end = omp_get_wtime();
+
+	Output_Fluxes_1D(&kn, u, F);
+
+	PROF_BEGIN(PROF_ERROR);
+	#pragma omp for reduction(+:Total_error, L1) reduction(max:Linf)
+	for (int i = 0; i < n; i++) {
+		Total_error += (u[i] - A[i])*(u[i] - A[i]);
+		L1 += fabs(u[i] - A[i]);
+		Linf = fmax(Linf, fabs(u[i] - A[i]));
+	}
+	PROF_END(PROF_ERROR);
+	}//end of parallel
+	Telemetry_Finish(&tm);
+
+	// Find the average
+	Total_error = (real)(Total_error / n);
+	printf("Total error %g\n", Total_error);
+	Print_Errors(L1 / n, Total_error, Linf);
+	Snapshot_Finish(&snap);
+	Snapshot_Finish(&chk);
+
+	/* Set dF/dx = 0 on left and right ends of our domain */
+	F[0] = F[1];
+	F[nif-1] = F[nif-2];
+
+	if (p->adaptive) printf("%d adaptive steps\n", nsteps);
+	printf("%d steps in %g s, %g cell updates/s\n", nsteps - start_step, t_end - t_start,
+	       (double)n*(nsteps - start_step) / (t_end - t_start));
+	PROF_BEGIN(PROF_OUTPUT);
+	Write_Output_1D(p, u, F, nsteps, p->adaptive ? p->t_final : nsteps*p->dt);
+	PROF_END(PROF_OUTPUT);
+	PROF_FINISH(stdout);
+
+	/* cleanup */
+	Kernel_1D_Free(&kn);
+	Field_Free(u);
+	Field_Free(F);
+	Field_Free(A);
+	free(saved);
+	return 0;
+}
+
+static int Run_2D(const struct Params *p)
+{
+	int nx = p->nx;
+	int ny = p->ny;
+	long n = (long)nx*ny;
+	real *T = Field_Alloc(p, n);
+	real *Tnew = Field_Alloc(p, n);
+	real *A = Field_Alloc(p, n);
+
+	if (!T || !Tnew || !A) {
+		fprintf(stderr, "allocation failed\n");
+		return 1;
+	}
+
+	struct Kernel_2D kn;
+	Kernel_2D_Init(&kn, p);
+	struct Amr *amr = p->amr_levels ? Amr_Create(p) : NULL;
+	struct Active_Tiles *active = p->active_tile ? Active_Create(p) : NULL;
+
+	struct Snapshot_Writer snap, chk;
+	if (Snapshot_Init(&snap, p, "T", n) != 0 || Checkpoint_Init(&chk, p, "T", n) != 0)
+		return 1;
+
+	int start_step;
+	real start_time;
+	real *saved = Load_Restart(p, n, &start_step, &start_time);
+
+	/* the step count of the "time += dt; if (time > t_final) break" loop,
+	   so the blocked mode knows up front how far to go */
+	int nsteps = p->adaptive ? 0 : Count_Timesteps(p);
+	struct Telemetry tm;
+	if (Telemetry_Start(&tm, p, start_step, nsteps) != 0)
+		return 1;
+
+	double t_start = 0.0, t_end = 0.0;
+
+	double Total_error = 0.0;
+	double L1 = 0.0, Linf = 0.0;
+	omp_set_num_threads(p->np);
+	PROF_INIT(p);
+	#pragma omp parallel
+	{
+	PROF_THREAD_START();
+	Pin_Threads(p);
+	Start_Field(p, T, saved);
+	Analytic_Solution(p, A);
+	Field_First_Touch(Tnew, nx, ny);
+	Kernel_2D_First_Touch(&kn);
+
+	/* T and Tnew are swapped every step instead of copied back; every
+	   thread swaps its own copy of the pointers the same way */
+	real *Tcur = T;
+	real *Tnxt = Tnew;
+	if (active)
+		Active_Start(active, &kn, Tcur, Tnxt);
+
+	#pragma omp barrier
+	#pragma omp master
+	t_start = omp_get_wtime();
+
+	if (p->adaptive) {
+		PROF_BEGIN(PROF_STEP);
+		int steps = Advance_Adaptive_2D(&kn, p, &Tcur, &Tnxt, &snap, &tm);
+		PROF_END(PROF_STEP);
+		#pragma omp master
+		nsteps = steps;
+	} else if (amr) {
+		PROF_BEGIN(PROF_STEP);
+		Amr_Advance(amr, &Tcur, &Tnxt, nsteps, &tm);
+		PROF_END(PROF_STEP);
+	} else {
+		/* run from one snapshot or checkpoint to the next */
+		for (int step = start_step; step < nsteps; ) {
+			int next = Snapshot_Next(&snap, step, nsteps);
+			int next_chk = Snapshot_Next(&chk, step, nsteps);
+			if (next_chk < next)
+				next = next_chk;
+
+			if (p->time_block > 1) {
+				PROF_BEGIN(PROF_STEP);
+				Advance_Blocked_2D(&kn, p, &Tcur, &Tnxt, next - step);
+				PROF_END(PROF_STEP);
+				#pragma omp master
+				Telemetry_Push(&tm, next, next*p->dt, (double)n*(next - start_step));
+			} else {
+				for (int timestep = step; timestep < next; timestep++) {
+
+					// Compute fluxes and update T in one pass
+					PROF_BEGIN(PROF_STEP);
+					if (active)
+						Active_Step_2D(active, &kn, Tcur, Tnxt);
+					else
+						Compute_Step_2D(&kn, Tcur, Tnxt);
+					PROF_END(PROF_STEP);
+
+					real *tmp = Tcur;
+					Tcur = Tnxt;
+					Tnxt = tmp;
+
+					#pragma omp master
+					Telemetry_Push(&tm, timestep + 1, (timestep + 1)*p->dt,
+						       (double)n*(timestep + 1 - start_step));
+				}
+			}
+			step = next;
+
+			PROF_BEGIN(PROF_SNAPSHOT);
+			if (Snapshot_Due(&snap, step))
+				Snapshot_Take(&snap, Tcur, step, step*p->dt);
+			if (step < nsteps && Snapshot_Due(&chk, step))
+				Snapshot_Take(&chk, Tcur, step, step*p->dt);
+			PROF_END(PROF_SNAPSHOT);
+		}
+	}
+
+	#pragma omp barrier
+	#pragma omp master
+	t_end = omp_get_wtime();
+
+	#pragma omp single
+	{
+		T = Tcur;
+		Tnew = Tnxt;
+	}
+
+	PROF_BEGIN(PROF_ERROR);
+	if (kn.sched) {
+		Sched_Errors_2D(kn.sched, T, A, &Total_error, &L1, &Linf);
+	} else {
+		#pragma omp for reduction(+:Total_error, L1) reduction(max:Linf)
+		for (long i = 0; i < n; i++) {
+			Total_error += (T[i] - A[i])*(T[i] - A[i]);
+			L1 += fabs(T[i] - A[i]);
+			Linf = fmax(Linf, fabs(T[i] - A[i]));
+		}
+	}
+	PROF_END(PROF_ERROR);
+	}//end of parallel
+	Telemetry_Finish(&tm);
+
+	// Find the average
+	Total_error = Total_error / n;
+	printf("Total error %g\n", Total_error);
+	Print_Errors(L1 / n, Total_error, Linf);
+	double updates = amr ? Amr_Updates(amr) : (double)n*(nsteps - start_step);
+	printf("%d steps in %g s, %g cell updates/s\n", nsteps - start_step, t_end - t_start,
+	       updates / (t_end - t_start));
+	if (kn.split)
+		Split_2D_Print(kn.split, stdout);
+	if (amr)
+		Amr_Print(amr, stdout);
+	if (active)
+		Active_Print(active, stdout);
+	if (kn.sched)
+		Sched_Print(kn.sched, stdout);
+	Snapshot_Finish(&snap);
+	Snapshot_Finish(&chk);
+
+	PROF_BEGIN(PROF_OUTPUT);
+	FILE *pFile;
+	if (p->debug) printf("Saving results\n");
+	pFile = fopen("results.txt", "w");
+	fprintf(pFile, "%ld\t%g\n", n, Total_error);
+	fclose(pFile);
+
+	Write_Output_2D(p, T, nsteps, p->adaptive ? p->t_final : nsteps*p->dt);
+	PROF_END(PROF_OUTPUT);
+	PROF_FINISH(stdout);
+
+	/* cleanup */
+	Kernel_2D_Free(&kn);
+	Amr_Free(amr);
+	Active_Free(active);
+	Field_Free(T);
+	Field_Free(Tnew);
+	Field_Free(A);
+	free(saved);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct Params p;
+
+	Params_Default(&p);
+	if (Params_Parse_Args(&p, argc, argv) != 0 || Params_Check(&p) != 0) {
+		fprintf(stderr, "usage: %s [config file | key=value] ...\n", argv[0]);
+		return 1;
+	}
+	if (p.debug) Params_Print(&p, stdout);
+
+	if (Ensemble_Enabled(&p))
+		return Ensemble_Run(&p);
+	if (p.dim == 1)
+		return Run_1D(&p);
+	return Run_2D(&p);
+}
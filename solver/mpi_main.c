@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <mpi.h>
+#include "params.h"
+#include "solver.h"
+#include "field_io.h"
+#include "field_alloc.h"
+
+/*
+   2D solver on a px x py grid of MPI ranks (hybrid: p->np OpenMP threads
+   per rank).  Rank (cx, cy) owns the cells [j0,j1) x [k0,k1) plus one
+   ghost layer on every side:
+
+       local (j, k) -> data[(j - j0 + 1)*stride + (k - k0 + 1)],  stride = k1-k0+2
+
+   which is a Grid_View with origin (j0-1, k0-1), so the kernels work in
+   global indices and handle the walls themselves.  Each step posts the
+   halo exchange, updates the interior cells that need no ghost values,
+   waits, then updates the one-cell ring along the block edges.  Every
+   cell goes through the same arithmetic as the shared-memory solver, so
+   the result is bitwise identical for any rank count.
+
+       make mpi
+       mpirun -np 4 ./main_mpi configs/2d_a_d.cfg np=1
+*/
+
+#ifdef USE_DOUBLE
+#define MPI_REAL_T MPI_DOUBLE
+#else
+#define MPI_REAL_T MPI_FLOAT
+#endif
+
+struct Block {
+	int rank, size;
+	int dims[2];            /* ranks in x, y */
+	int coords[2];
+	int west, east, south, north;   /* neighbour ranks, MPI_PROC_NULL on walls */
+	int j0, j1, k0, k1;     /* owned cells */
+	int lnx, lny;
+	int stride;
+	MPI_Comm comm;
+	MPI_Datatype column;    /* one ghost/edge column: lnx values, stride apart */
+};
+
+static int Block_Init(struct Block *b, const struct Params *p)
+{
+	int periods[2] = { 0, 0 };
+
+	MPI_Comm_size(MPI_COMM_WORLD, &b->size);
+	b->dims[0] = b->dims[1] = 0;
+	MPI_Dims_create(b->size, 2, b->dims);
+	MPI_Cart_create(MPI_COMM_WORLD, 2, b->dims, periods, 1, &b->comm);
+	MPI_Comm_rank(b->comm, &b->rank);
+	MPI_Cart_coords(b->comm, b->rank, 2, b->coords);
+	MPI_Cart_shift(b->comm, 0, 1, &b->west, &b->east);
+	MPI_Cart_shift(b->comm, 1, 1, &b->south, &b->north);
+
+	b->j0 = (int)((long)p->nx*b->coords[0]/b->dims[0]);
+	b->j1 = (int)((long)p->nx*(b->coords[0]+1)/b->dims[0]);
+	b->k0 = (int)((long)p->ny*b->coords[1]/b->dims[1]);
+	b->k1 = (int)((long)p->ny*(b->coords[1]+1)/b->dims[1]);
+	b->lnx = b->j1 - b->j0;
+	b->lny = b->k1 - b->k0;
+	b->stride = b->lny + 2;
+
+	/* the interior/edge split needs at least one interior cell */
+	if (p->nx/b->dims[0] < 3 || p->ny/b->dims[1] < 3) {
+		if (b->rank == 0)
+			fprintf(stderr, "%d x %d grid too small for %d x %d ranks\n",
+				p->nx, p->ny, b->dims[0], b->dims[1]);
+		return -1;
+	}
+
+	MPI_Type_vector(b->lnx, 1, b->stride, MPI_REAL_T, &b->column);
+	MPI_Type_commit(&b->column);
+	return 0;
+}
+
+static inline real *At(const struct Block *b, real *T, int j, int k)
+{
+	return T + (long)(j - b->j0 + 1)*b->stride + (k - b->k0 + 1);
+}
+
+/* Posts the receives into the ghost layer and the sends of the edge
+   cells; rows (fixed j) are contiguous, columns use b->column. */
+static void Halo_Start(const struct Block *b, real *T, MPI_Request req[8])
+{
+	int lny = b->lny;
+
+	MPI_Irecv(At(b, T, b->j0 - 1, b->k0), lny, MPI_REAL_T, b->west, 0, b->comm, &req[0]);
+	MPI_Irecv(At(b, T, b->j1, b->k0), lny, MPI_REAL_T, b->east, 1, b->comm, &req[1]);
+	MPI_Irecv(At(b, T, b->j0, b->k0 - 1), 1, b->column, b->south, 2, b->comm, &req[2]);
+	MPI_Irecv(At(b, T, b->j0, b->k1), 1, b->column, b->north, 3, b->comm, &req[3]);
+
+	MPI_Isend(At(b, T, b->j1 - 1, b->k0), lny, MPI_REAL_T, b->east, 0, b->comm, &req[4]);
+	MPI_Isend(At(b, T, b->j0, b->k0), lny, MPI_REAL_T, b->west, 1, b->comm, &req[5]);
+	MPI_Isend(At(b, T, b->j0, b->k1 - 1), 1, b->column, b->north, 2, b->comm, &req[6]);
+	MPI_Isend(At(b, T, b->j0, b->k0), 1, b->column, b->south, 3, b->comm, &req[7]);
+}
+
+/* One step from cur to nxt; called by every thread of the parallel
+   region.  Communication is funneled through the master thread. */
+static void Step_Block(const struct Block *b, const struct Kernel_2D *kn,
+		       real *cur, real *nxt, MPI_Request req[8], double *t_wait)
+{
+	struct Grid_View src = { cur, b->j0 - 1, b->k0 - 1, b->stride };
+	struct Grid_View dst = { nxt, b->j0 - 1, b->k0 - 1, b->stride };
+
+	#pragma omp master
+	Halo_Start(b, cur, req);
+
+	/* interior: no ghost cell is read */
+	#pragma omp for schedule(static) nowait
+	for (int j = b->j0 + 1; j < b->j1 - 1; j++)
+		kn->region(kn, &src, &dst, j, j + 1, b->k0 + 1, b->k1 - 1);
+
+	#pragma omp master
+	{
+		double t0 = MPI_Wtime();
+		MPI_Waitall(8, req, MPI_STATUSES_IGNORE);
+		*t_wait += MPI_Wtime() - t0;
+	}
+	#pragma omp barrier
+
+	/* the edge ring: first and last row whole, both end cells of the rest */
+	#pragma omp for schedule(static)
+	for (int j = b->j0; j < b->j1; j++) {
+		if (j == b->j0 || j == b->j1 - 1) {
+			kn->region(kn, &src, &dst, j, j + 1, b->k0, b->k1);
+		} else {
+			kn->region(kn, &src, &dst, j, j + 1, b->k0, b->k0 + 1);
+			kn->region(kn, &src, &dst, j, j + 1, b->k1 - 1, b->k1);
+		}
+	}
+}
+
+/* resultsT.fld: rank 0 writes the header, every rank its own block */
+static void Write_Field(const struct Block *b, const struct Params *p, real *T, int nsteps)
+{
+	struct Field_Header h;
+	struct Field_Var var = { "T", NULL, (long)p->nx*p->ny };
+	MPI_File fh;
+
+	Field_Header_Init(&h, p, nsteps, nsteps*p->dt, 1, &var);
+	if (MPI_File_open(b->comm, "resultsT.fld", MPI_MODE_CREATE | MPI_MODE_WRONLY,
+			  MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+		if (b->rank == 0)
+			fprintf(stderr, "cannot open resultsT.fld\n");
+		return;
+	}
+	MPI_File_set_size(fh, 0);
+	if (b->rank == 0)
+		MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+
+	int gsize[2] = { p->nx, p->ny };
+	int lsize[2] = { b->lnx, b->lny };
+	int gstart[2] = { b->j0, b->k0 };
+	int msize[2] = { b->lnx + 2, b->stride };
+	int mstart[2] = { 1, 1 };
+	MPI_Datatype filetype, memtype;
+	MPI_Type_create_subarray(2, gsize, lsize, gstart, MPI_ORDER_C, MPI_REAL_T, &filetype);
+	MPI_Type_create_subarray(2, msize, lsize, mstart, MPI_ORDER_C, MPI_REAL_T, &memtype);
+	MPI_Type_commit(&filetype);
+	MPI_Type_commit(&memtype);
+
+	MPI_File_set_view(fh, h.var[0].offset, MPI_REAL_T, filetype, "native", MPI_INFO_NULL);
+	MPI_File_write_all(fh, T, 1, memtype, MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+	MPI_Type_free(&filetype);
+	MPI_Type_free(&memtype);
+}
+
+static int Run_MPI(const struct Params *p)
+{
+	struct Block b;
+	if (Block_Init(&b, p) != 0)
+		return 1;
+
+	long nlocal = (long)(b.lnx + 2)*b.stride;
+	real *T = Field_Alloc(p, nlocal);
+	real *Tnew = Field_Alloc(p, nlocal);
+	real *A = Field_Alloc(p, nlocal);
+	if (!T || !Tnew || !A) {
+		fprintf(stderr, "allocation failed\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	struct Kernel_2D kn;
+	Kernel_2D_Init(&kn, p);
+	int nsteps = Count_Timesteps(p);
+	double t_start = 0.0, t_end = 0.0, t_wait = 0.0;
+	double local_error = 0.0;
+	MPI_Request req[8];
+
+	omp_set_num_threads(p->np);
+	#pragma omp parallel
+	{
+	Pin_Threads(p);
+	Field_First_Touch(T, b.lnx + 2, b.stride);
+	Field_First_Touch(Tnew, b.lnx + 2, b.stride);
+	Field_First_Touch(A, b.lnx + 2, b.stride);
+
+	struct Grid_View gT = { T, b.j0 - 1, b.k0 - 1, b.stride };
+	struct Grid_View gA = { A, b.j0 - 1, b.k0 - 1, b.stride };
+	Pulse_Region(p, 0.0, &gT, b.j0, b.j1, b.k0, b.k1);
+	Pulse_Region(p, p->t_final, &gA, b.j0, b.j1, b.k0, b.k1);
+
+	real *Tcur = T;
+	real *Tnxt = Tnew;
+
+	#pragma omp master
+	{
+		MPI_Barrier(b.comm);
+		t_start = MPI_Wtime();
+	}
+	#pragma omp barrier
+
+	for (int timestep = 0; timestep < nsteps; timestep++) {
+		Step_Block(&b, &kn, Tcur, Tnxt, req, &t_wait);
+
+		real *tmp = Tcur;
+		Tcur = Tnxt;
+		Tnxt = tmp;
+	}
+
+	#pragma omp barrier
+	#pragma omp master
+	t_end = MPI_Wtime();
+
+	#pragma omp single
+	{
+		T = Tcur;
+		Tnew = Tnxt;
+	}
+
+	#pragma omp for reduction(+:local_error)
+	for (int j = b.j0; j < b.j1; j++) {
+		for (int k = b.k0; k < b.k1; k++) {
+			real d = *At(&b, T, j, k) - *At(&b, A, j, k);
+			local_error += d*d;
+		}
+	}
+	}//end of parallel
+
+	/* the slowest rank sets the pace */
+	double Total_error, elapsed, local_elapsed = t_end - t_start, max_wait;
+	MPI_Reduce(&local_error, &Total_error, 1, MPI_DOUBLE, MPI_SUM, 0, b.comm);
+	MPI_Reduce(&local_elapsed, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, b.comm);
+	MPI_Reduce(&t_wait, &max_wait, 1, MPI_DOUBLE, MPI_MAX, 0, b.comm);
+
+	long n = (long)p->nx*p->ny;
+	if (b.rank == 0) {
+		Total_error = Total_error / n;
+		printf("Total error %g\n", Total_error);
+		printf("%d ranks (%d x %d) x %d threads, %d steps in %g s, %g cell updates/s, "
+		       "halo wait %g s\n", b.size, b.dims[0], b.dims[1], p->np, nsteps, elapsed,
+		       (double)n*nsteps / elapsed, max_wait);
+
+		FILE *pFile = fopen("results.txt", "w");
+		fprintf(pFile, "%ld\t%g\n", n, Total_error);
+		fclose(pFile);
+	}
+	Write_Field(&b, p, T, nsteps);
+
+	MPI_Type_free(&b.column);
+	MPI_Comm_free(&b.comm);
+	Field_Free(T);
+	Field_Free(Tnew);
+	Field_Free(A);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct Params p;
+	int provided, rank;
+
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	Params_Default(&p);
+	if (Params_Parse_Args(&p, argc, argv) != 0 || Params_Check(&p) != 0 || p.dim != 2) {
+		if (rank == 0)
+			fprintf(stderr, "usage: %s [config file | key=value] ... (2D only)\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	/* ignoring it would leave dt unset */
+	if (p.adaptive) {
+		if (rank == 0)
+			fprintf(stderr, "main_mpi: adaptive=1 is not supported, set dt\n");
+		MPI_Finalize();
+		return 1;
+	}
+	if (p.debug && rank == 0) Params_Print(&p, stdout);
+	if (rank == 0 && (p.output != OUTPUT_BINARY || p.time_block > 1 ||
+			  p.snapshot_every || p.snapshot_dt > 0.0 || p.checkpoint_every || p.restart[0] ||
+			  p.limiter != LIMITER_NONE || p.rk > 1 || p.diffusion != DIFFUSION_EXPLICIT ||
+			  p.amr_levels || p.active_tile || p.sweep_u[0] || p.sweep_v[0] || p.sweep_alpha[0] ||
+			  p.progress > 0.0 || p.steal))
+		fprintf(stderr, "main_mpi: output=text, time_block, snapshots, checkpoints, "
+			"limiter/rk, implicit diffusion, amr, active tiles, sweeps, progress and steal are not supported, ignored\n");
+	p.limiter = LIMITER_NONE;
+	p.rk = 1;
+	p.diffusion = DIFFUSION_EXPLICIT;
+	p.amr_levels = 0;
+	p.active_tile = 0;
+	p.sweep_u[0] = p.sweep_v[0] = p.sweep_alpha[0] = '\0';
+	p.progress = 0.0;
+	p.steal = 0;
+
+	int err = Run_MPI(&p);
+	MPI_Finalize();
+	return err;
+}
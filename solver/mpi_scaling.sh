@@ -0,0 +1,28 @@
+#!/bin/sh
+# Strong and weak scaling of main_mpi on this box (make mpi first).
+#   ./mpi_scaling.sh [max ranks] [extra key=value ...]
+# Strong: 800x800 on 1, 2, 4 ... ranks.  Weak: 400x400 cells per rank.
+# Threads per rank default to np=1; more ranks than cores oversubscribe.
+
+MAX=${1:-4}
+[ $# -gt 0 ] && shift
+MPIRUN="mpirun --oversubscribe"
+[ "$(id -u)" = 0 ] && MPIRUN="$MPIRUN --allow-run-as-root"
+RUN="./main_mpi configs/2d_a_d.cfg np=1 debug=0 t_final=0.05"
+
+echo "strong scaling, 800x800"
+r=1
+while [ $r -le $MAX ]; do
+	$MPIRUN -np $r $RUN nx=800 ny=800 "$@" | grep ranks
+	r=$((r*2))
+done
+
+echo "weak scaling, 400x400 per rank"
+r=1
+nx=400
+ny=400
+while [ $r -le $MAX ]; do
+	$MPIRUN -np $r $RUN nx=$nx ny=$ny "$@" | grep ranks
+	r=$((r*2))
+	if [ $nx -eq $ny ]; then nx=$((nx*2)); else ny=$((ny*2)); fi
+done
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "multigrid.h"
+#include "field_alloc.h"
+#include "simd.h"
+
+#define MG_PRE 2                /* smoothing sweeps before the correction */
+#define MG_POST 2               /* and after */
+#define MG_COARSE 16            /* sweeps on the coarsest level */
+
+enum { RED, BLACK };
+
+/* The reductions go into file-scope variables so that they are shared by
+   the threads of the enclosing parallel region. */
+static double mg_res, mg_norm;
+
+/* rows [j0, j1) of this thread's block of n rows */
+#define THREAD_ROWS(n, t, nthreads, j0, j1)              \
+	int j0 = (int)((long)(n)*(t)/(nthreads));         \
+	int j1 = (int)((long)(n)*((t)+1)/(nthreads))
+
+/*
+   Gauss-Seidel on the cells of one colour of row j.  A missing
+   neighbour on a wall is the cell itself, as in the explicit kernel;
+   that keeps the fixed point of the mirrored operator and lets the
+   inside of the row run without wall tests.
+*/
+static void Relax_Row(const struct Mg_Level *l, int j, int color)
+{
+	int nx = l->nx;
+	int ny = l->ny;
+	real rx = l->rx;
+	real ry = l->ry;
+	real inv = 1 / (1 + 2*rx + 2*ry);
+	real *u = l->u + (long)j*ny;
+	const real *f = l->f + (long)j*ny;
+	const real *us = (j > 0) ? u - ny : u;
+	const real *un = (j < nx-1) ? u + ny : u;
+	int k0 = (j + color) & 1;
+
+	if (k0 == 0) {
+		int ke = (ny > 1) ? 1 : 0;
+		u[0] = (f[0] + rx*(us[0] + un[0]) + ry*(u[0] + u[ke]))*inv;
+	}
+	for (int k = (k0 == 0) ? 2 : 1; k < ny-1; k += 2)
+		u[k] = (f[k] + rx*(us[k] + un[k]) + ry*(u[k-1] + u[k+1]))*inv;
+	int k = ny-1;
+	if (k > 0 && ((j + k) & 1) == color)
+		u[k] = (f[k] + rx*(us[k] + un[k]) + ry*(u[k-1] + u[k]))*inv;
+}
+
+/*
+   Red-black sweeps.  Each thread relaxes red row j and then black row
+   j-1 of its block, whose red neighbours are all done; only the black
+   rows on the edges of a block wait for the neighbouring block.  The
+   result is the same as two full colour passes for any thread count.
+*/
+static void Smooth(const struct Mg_Level *l, int sweeps)
+{
+	int nthreads = omp_get_num_threads();
+
+	for (int s = 0; s < sweeps; s++) {
+		#pragma omp for schedule(static)
+		for (int t = 0; t < nthreads; t++) {
+			THREAD_ROWS(l->nx, t, nthreads, j0, j1);
+			for (int j = j0; j < j1; j++) {
+				Relax_Row(l, j, RED);
+				if (j-1 > j0)
+					Relax_Row(l, j-1, BLACK);
+			}
+		}
+		#pragma omp for schedule(static)
+		for (int t = 0; t < nthreads; t++) {
+			THREAD_ROWS(l->nx, t, nthreads, j0, j1);
+			if (j0 < j1)
+				Relax_Row(l, j0, BLACK);
+			if (j1-1 > j0)
+				Relax_Row(l, j1-1, BLACK);
+		}
+	}
+}
+
+/* res = f - A u along row j; returns max |res| */
+static double Residual_Row(const struct Mg_Level *l, int j, real *res)
+{
+	int nx = l->nx;
+	int ny = l->ny;
+	real rx = l->rx;
+	real ry = l->ry;
+	const real *u = l->u + (long)j*ny;
+	const real *f = l->f + (long)j*ny;
+	const real *us = (j > 0) ? u - ny : u;
+	const real *un = (j < nx-1) ? u + ny : u;
+	double m = 0.0;
+
+	for (int k = 0; k < ny; k++) {
+		int kw = (k > 0) ? k-1 : k;
+		int ke = (k < ny-1) ? k+1 : k;
+		res[k] = f[k] - (u[k] + rx*(2*u[k] - us[k] - un[k]) + ry*(2*u[k] - u[kw] - u[ke]));
+		real a = (res[k] < 0) ? -res[k] : res[k];
+		if (a > m)
+			m = a;
+	}
+	return m;
+}
+
+/* the fine cells i[] and weights w[] that restrict onto coarse cell I */
+static int Restrict_Weights(int mode, int I, int n, int *i, real *w)
+{
+	int cnt = 0;
+
+	switch (mode) {
+	case MG_CELL:
+		i[0] = 2*I;
+		i[1] = 2*I + 1;
+		w[0] = w[1] = (real)0.5;
+		return 2;
+	case MG_VERTEX: {
+		real sum = 0;
+		if (2*I-1 >= 0) {
+			i[cnt] = 2*I-1;
+			w[cnt++] = (real)0.25;
+		}
+		i[cnt] = 2*I;
+		w[cnt++] = (real)0.5;
+		if (2*I+1 < n) {
+			i[cnt] = 2*I+1;
+			w[cnt++] = (real)0.25;
+		}
+		for (int q = 0; q < cnt; q++)
+			sum += w[q];
+		for (int q = 0; q < cnt; q++)
+			w[q] /= sum;
+		return cnt;
+	}
+	default:
+		i[0] = I;
+		w[0] = 1;
+		return 1;
+	}
+}
+
+/* the coarse cells I0, I1 interpolated onto fine cell i, weights w0, 1-w0 */
+static inline void Prolong_Weights(int mode, int i, int nc, int *I0, int *I1, real *w0)
+{
+	int I = i/2;
+
+	switch (mode) {
+	case MG_CELL:
+		*I0 = I;
+		*I1 = (i & 1) ? I+1 : I-1;
+		if (*I1 < 0 || *I1 >= nc)
+			*I1 = I;
+		*w0 = (real)0.75;
+		break;
+	case MG_VERTEX:
+		*I0 = I;
+		*I1 = (i & 1) ? I+1 : I;
+		*w0 = (i & 1) ? (real)0.5 : 1;
+		break;
+	default:
+		*I0 = *I1 = i;
+		*w0 = 1;
+		break;
+	}
+}
+
+/* max |f - A u| on level lv, and its restriction as the f of level lv+1 */
+static double Residual_Restrict(const struct Multigrid *mg, int lv)
+{
+	const struct Mg_Level *l = &mg->level[lv];
+	const struct Mg_Level *c = (lv+1 < mg->nlevels) ? &mg->level[lv+1] : NULL;
+	real *res = mg->scratch + (long)omp_get_thread_num()*mg->level[0].ny;
+	int rows = c ? c->nx : l->nx;
+
+	#pragma omp single
+	mg_res = 0.0;
+
+	#pragma omp for schedule(static) reduction(max:mg_res)
+	for (int J = 0; J < rows; J++) {
+		if (!c) {
+			double m = Residual_Row(l, J, res);
+			if (m > mg_res)
+				mg_res = m;
+			continue;
+		}
+
+		int jr[3], kr[3];
+		real wx[3], wy[3];
+		int nj = Restrict_Weights(l->cx, J, l->nx, jr, wx);
+		real *fc = c->f + (long)J*c->ny;
+
+		for (int K = 0; K < c->ny; K++)
+			fc[K] = 0;
+		for (int q = 0; q < nj; q++) {
+			double m = Residual_Row(l, jr[q], res);
+			if (m > mg_res)
+				mg_res = m;
+			for (int K = 0; K < c->ny; K++) {
+				int nk = Restrict_Weights(l->cy, K, l->ny, kr, wy);
+				real sum = 0;
+				for (int t = 0; t < nk; t++)
+					sum += wy[t]*res[kr[t]];
+				fc[K] += wx[q]*sum;
+			}
+		}
+	}
+	return mg_res;
+}
+
+/* u of level lv += interpolation of the u of level lv+1 */
+static void Prolong(const struct Multigrid *mg, int lv)
+{
+	const struct Mg_Level *l = &mg->level[lv];
+	const struct Mg_Level *c = &mg->level[lv+1];
+	int ny = l->ny;
+	int cny = c->ny;
+
+	#pragma omp for schedule(static)
+	for (int j = 0; j < l->nx; j++) {
+		int J0, J1;
+		real wx;
+		Prolong_Weights(l->cx, j, c->nx, &J0, &J1, &wx);
+		const real *e0 = c->u + (long)J0*cny;
+		const real *e1 = c->u + (long)J1*cny;
+		real *u = l->u + (long)j*ny;
+
+		for (int k = 0; k < ny; k++) {
+			int K0, K1;
+			real wy;
+			Prolong_Weights(l->cy, k, cny, &K0, &K1, &wy);
+			u[k] += wx*(wy*e0[K0] + (1-wy)*e0[K1]) + (1-wx)*(wy*e1[K0] + (1-wy)*e1[K1]);
+		}
+	}
+}
+
+/* V-cycle for the correction on levels lv.. from a zero guess */
+static void Correct(const struct Multigrid *mg, int lv)
+{
+	const struct Mg_Level *l = &mg->level[lv];
+
+	#pragma omp for schedule(static)
+	for (int j = 0; j < l->nx; j++)
+		memset(l->u + (long)j*l->ny, 0, l->ny*sizeof(real));
+
+	if (lv == mg->nlevels-1) {
+		Smooth(l, MG_COARSE);
+		return;
+	}
+	Smooth(l, MG_PRE);
+	Residual_Restrict(mg, lv);
+	Correct(mg, lv+1);
+	Prolong(mg, lv);
+	Smooth(l, MG_POST);
+}
+
+void Multigrid_Diffuse(struct Multigrid *mg, const real *src, real *dst)
+{
+	const struct Mg_Level *l = &mg->level[0];
+	int ny = l->ny;
+	double t0 = omp_get_wtime();
+
+	/* the corrections of a nearly converged solve underflow otherwise;
+	   the caller's mode is restored below */
+	unsigned long fp_mode = Simd_Flush_Denormals_Save();
+
+	#pragma omp single
+	{
+		mg->level[0].u = dst;
+		mg_norm = 0.0;
+	}
+
+	#pragma omp for schedule(static) reduction(max:mg_norm)
+	for (int j = 0; j < l->nx; j++) {
+		const real *t = src + (long)j*ny;
+		real *f = l->f + (long)j*ny;
+		real *u = dst + (long)j*ny;
+		for (int k = 0; k < ny; k++) {
+			f[k] = t[k];
+			u[k] = t[k];
+			double a = (t[k] < 0) ? -t[k] : t[k];
+			if (a > mg_norm)
+				mg_norm = a;
+		}
+	}
+	double norm = mg_norm;
+
+	int cycles = 0;
+	double res;
+	for (;;) {
+		Smooth(l, MG_PRE);
+		res = Residual_Restrict(mg, 0) / (1 + 2*l->rx + 2*l->ry);
+		if (res <= mg->tol*norm || cycles == mg->max_cycles)
+			break;
+		if (mg->nlevels > 1) {
+			Correct(mg, 1);
+			Prolong(mg, 0);
+		}
+		Smooth(l, MG_POST);
+		cycles++;
+	}
+
+	#pragma omp master
+	{
+		mg->solves++;
+		mg->cycles += cycles;
+		mg->time += omp_get_wtime() - t0;
+		mg->residual = (norm > 0.0) ? res/norm : 0.0;
+	}
+	Simd_Restore_Denormals(fp_mode);
+}
+
+void Multigrid_Set_Dt(struct Multigrid *mg, double dt)
+{
+	double rx = dt*mg->kd;
+	double ry = rx;
+
+	/* a coarsened direction has twice the spacing */
+	for (int i = 0; i < mg->nlevels; i++) {
+		mg->level[i].rx = (real)rx;
+		mg->level[i].ry = (real)ry;
+		if (mg->level[i].cx != MG_KEEP)
+			rx *= 0.25;
+		if (mg->level[i].cy != MG_KEEP)
+			ry *= 0.25;
+	}
+}
+
+/* untouched until Multigrid_First_Touch */
+static real *Alloc_Level(const struct Params *p, long n)
+{
+	real *a = Field_Alloc(p, n);
+	if (!a) {
+		fprintf(stderr, "allocation failed\n");
+		exit(1);
+	}
+	return a;
+}
+
+void Multigrid_First_Touch(const struct Multigrid *mg)
+{
+	for (int i = 0; i < mg->nlevels; i++) {
+		const struct Mg_Level *l = &mg->level[i];
+		Field_First_Touch(l->f, l->nx, l->ny);
+		if (i > 0)
+			Field_First_Touch(l->u, l->nx, l->ny);
+	}
+	Field_First_Touch(mg->scratch, mg->np, mg->level[0].ny);
+}
+
+struct Multigrid *Multigrid_Create(const struct Params *p)
+{
+	struct Multigrid *mg = Work_Alloc(sizeof *mg);
+
+	int nx = p->nx;
+	int ny = p->ny;
+	for (;;) {
+		struct Mg_Level *l = &mg->level[mg->nlevels++];
+		l->nx = nx;
+		l->ny = ny;
+		l->f = Alloc_Level(p, (long)nx*ny);
+		if (mg->nlevels > 1)
+			l->u = Alloc_Level(p, (long)nx*ny);
+		l->cx = (nx < 3) ? MG_KEEP : (nx & 1) ? MG_VERTEX : MG_CELL;
+		l->cy = (ny < 3) ? MG_KEEP : (ny & 1) ? MG_VERTEX : MG_CELL;
+		if ((l->cx == MG_KEEP && l->cy == MG_KEEP) || mg->nlevels == MG_MAX_LEVELS) {
+			l->cx = l->cy = MG_KEEP;
+			break;
+		}
+		if (l->cx != MG_KEEP)
+			nx = (nx + 1)/2;
+		if (l->cy != MG_KEEP)
+			ny = (ny + 1)/2;
+	}
+
+	mg->kd = p->alpha/(p->ly/p->ny)/(p->ly/p->ny);
+	mg->tol = p->mg_tol;
+	mg->max_cycles = p->mg_cycles;
+	mg->np = p->np;
+	mg->scratch = Alloc_Level(p, (long)p->np*p->ny);
+	Multigrid_Set_Dt(mg, p->dt);
+	return mg;
+}
+
+void Multigrid_Free(struct Multigrid *mg)
+{
+	if (!mg)
+		return;
+	for (int i = 0; i < mg->nlevels; i++) {
+		Field_Free(mg->level[i].f);
+		if (i > 0)
+			Field_Free(mg->level[i].u);
+	}
+	Field_Free(mg->scratch);
+	free(mg);
+}
+
+void Multigrid_Print(const struct Multigrid *mg, FILE *fp)
+{
+	if (!mg->solves)
+		return;
+	fprintf(fp, "multigrid: %d levels, %ld solves, %.2f V-cycles/solve, %g s/solve, residual %.2g\n",
+		mg->nlevels, mg->solves, (double)mg->cycles/mg->solves, mg->time/mg->solves,
+		mg->residual);
+}
@@ -0,0 +1,68 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <stdio.h>
+#include "solver.h"
+
+/*
+   Backward-Euler diffusion for 2D (diffusion=be): one time step
+
+       (1 - dt*alpha*Laplacian) T' = T
+
+   is solved with geometric multigrid V-cycles, with the mirrored
+   (zero-gradient) walls of the explicit kernels.  Each direction is
+   coarsened by 2 while it has 3 or more cells: an even count as cell
+   pairs (averaging restriction, bilinear prolongation), an odd count on
+   every other cell (full weighting, linear prolongation), so any grid
+   size gets the full hierarchy.  The smoother is red-black Gauss-Seidel,
+   both colours done in one pass per thread block of rows (black row j-1
+   right after red row j), so each sweep reads the level once.  Cycles
+   stop when the residual, scaled by the diagonal, is at most
+   mg_tol*max|T|, or after mg_cycles.  The cost per solve is O(nx*ny)
+   for any dt.
+
+   Driven by the operator splitting in split.c; Multigrid_Diffuse is
+   called by every thread of a parallel region.
+*/
+
+#define MG_MAX_LEVELS 16
+
+enum { MG_KEEP, MG_CELL, MG_VERTEX };
+
+struct Mg_Level {
+	int nx, ny;
+	int cx, cy;             /* how the next level coarsens: MG_* */
+	real rx, ry;            /* dt*alpha/h^2 at this level's spacing */
+	real *u, *f;            /* level 0: u is the field being solved */
+};
+
+struct Multigrid {
+	int nlevels;
+	struct Mg_Level level[MG_MAX_LEVELS];
+	double kd;              /* alpha/dy^2 of the fine grid */
+	double tol;
+	int max_cycles;
+	int np;                 /* threads, one scratch row each */
+	real *scratch;          /* a fine row of residual per thread */
+
+	/* per run, updated by the master thread */
+	long solves, cycles;
+	double time;
+	double residual;        /* relative, of the last solve */
+};
+
+struct Multigrid *Multigrid_Create(const struct Params *p);
+void Multigrid_Set_Dt(struct Multigrid *mg, double dt);
+void Multigrid_Free(struct Multigrid *mg);
+
+/* zeroes every level by rows and every thread's own scratch row; called
+   by every thread of the parallel region before the first solve */
+void Multigrid_First_Touch(const struct Multigrid *mg);
+
+/* src -> dst, which may be the same field; src is the first guess */
+void Multigrid_Diffuse(struct Multigrid *mg, const real *src, real *dst);
+
+/* "multigrid: solves, V-cycles per solve, time per solve" */
+void Multigrid_Print(const struct Multigrid *mg, FILE *fp);
+
+#endif
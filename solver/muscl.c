@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <omp.h>
+#include "muscl.h"
+#include "riemann.h"
+#include "field_alloc.h"
+
+/* added to the van Leer denominator so 0/0 cannot happen */
+#define LIMIT_TINY ((real)FLT_MIN)
+
+/*
+   limited slope from the left and right differences, 0 where they
+   differ in sign.  Written without branches so the row loops
+   vectorize once the limiter is a constant.
+*/
+static inline __attribute__((always_inline))
+real Limit(int limiter, real dl, real dr)
+{
+	real al = (dl < 0) ? -dl : dl;
+	real ar = (dr < 0) ? -dr : dr;
+	real m;
+
+	switch (limiter) {
+	case LIMITER_MINMOD:
+		m = (al < ar) ? al : ar;
+		break;
+	case LIMITER_VANLEER:
+		/* 2*dl*dr/(dl+dr) for same signs, 0 otherwise */
+		return (dl*ar + al*dr) / (al + ar + LIMIT_TINY);
+	case LIMITER_MC:
+		m = (real)0.5*(al + ar);
+		m = (2*al < m) ? 2*al : m;
+		m = (2*ar < m) ? 2*ar : m;
+		break;
+	default:
+		return 0;
+	}
+	m = (dl*dr > 0) ? m : 0;
+	return (dl < 0) ? -m : m;
+}
+
+/* ---------------------------------------------------------------- 1D */
+
+/* slope of cell i; the wall cells stay first order */
+static inline real Slope_1D(int limiter, const real *u, int i, int n)
+{
+	if (i <= 0 || i >= n-1)
+		return 0;
+	return Limit(limiter, u[i] - u[i-1], u[i+1] - u[i]);
+}
+
+/* F[j], j in [1, n), from the reconstructed states either side of it */
+static inline __attribute__((always_inline))
+void Muscl_Fluxes_1D_Body(const struct Kernel_1D *kn, const real *u, real *F, int flux, int limiter)
+{
+	int n = kn->n;
+	double alpha_dx = kn->alpha_dx;
+
+	#pragma omp for schedule(static)
+	for (int j = 1; j < n; j++) {
+		real uL = u[j-1] + (real)0.5*Slope_1D(limiter, u, j-1, n);
+		real uR = u[j] - (real)0.5*Slope_1D(limiter, u, j, n);
+		F[j] = Riemann_Flux(flux, kn->a, uL, uR) - alpha_dx*(u[j] - u[j-1]);
+	}
+}
+
+/* one copy per (flux scheme, limiter), like the first-order kernels */
+#define LIMITER_SWITCH(BODY, ...)                                 \
+	switch (kn->limiter) {                                    \
+	case LIMITER_MINMOD:  BODY(__VA_ARGS__, LIMITER_MINMOD);  break; \
+	case LIMITER_VANLEER: BODY(__VA_ARGS__, LIMITER_VANLEER); break; \
+	case LIMITER_MC:      BODY(__VA_ARGS__, LIMITER_MC);      break; \
+	default:              BODY(__VA_ARGS__, LIMITER_NONE);    break; \
+	}
+
+#define MUSCL_1D(FLUX, NAME)                                                              \
+static void Muscl_Fluxes_1D_##NAME(const struct Kernel_1D *kn, const real *u, real *F)     \
+{                                                                                         \
+	LIMITER_SWITCH(Muscl_Fluxes_1D_Body, kn, u, F, FLUX)                              \
+}
+RIEMANN_SCHEMES(MUSCL_1D)
+
+#define MUSCL_1D_ENTRY(FLUX, NAME) [FLUX] = Muscl_Fluxes_1D_##NAME,
+static const Fluxes_1D_Fn muscl_fluxes_1d[NUM_FLUX_SCHEMES] = {
+	RIEMANN_SCHEMES(MUSCL_1D_ENTRY)
+};
+
+/* dst = c0*base + c1*(src - dt/dx*dF); the wall cells never change */
+static void Stage_1D(const struct Kernel_1D *kn, const real *src, const real *base, real *dst,
+		     const real *F, double c0, double c1)
+{
+	int n = kn->n;
+	double dtdx = kn->dtdx;
+
+	#pragma omp for schedule(static)
+	for (int i = 0; i < n; i++) {
+		double du = (i == 0 || i == n-1) ? 0.0 : dtdx*(F[i+1] - F[i]);
+		dst[i] = c0*base[i] + c1*(src[i] - du);
+	}
+}
+
+/* F already holds the fluxes of u (Compute_Fluxes_1D); later stages use
+   the kernel's own flux buffer, so F is left as the caller computed it */
+static void Muscl_Update_1D(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	real *s = kn->stage;
+	real *sF = kn->stage_flux;
+
+	switch (kn->rk) {
+	case 1:
+		Stage_1D(kn, u, u, u, F, 0.0, 1.0);
+		break;
+	case 2:
+		Stage_1D(kn, u, u, s, F, 0.0, 1.0);
+		kn->fluxes(kn, s, sF);
+		Stage_1D(kn, s, u, u, sF, 0.5, 0.5);
+		break;
+	default:
+		Stage_1D(kn, u, u, s, F, 0.0, 1.0);
+		kn->fluxes(kn, s, sF);
+		Stage_1D(kn, s, u, s, sF, 0.75, 0.25);
+		kn->fluxes(kn, s, sF);
+		Stage_1D(kn, s, u, u, sF, 1.0/3.0, 2.0/3.0);
+		break;
+	}
+}
+
+void Muscl_1D_Init(struct Kernel_1D *k, const struct Params *p)
+{
+	k->limiter = p->limiter;
+	k->rk = p->rk;
+	k->fluxes = muscl_fluxes_1d[k->flux];
+	k->update = Muscl_Update_1D;
+	k->stage = Field_Alloc(p, k->n);
+	k->stage_flux = Field_Alloc(p, k->n + 1);
+	if (!k->stage || !k->stage_flux) {
+		fprintf(stderr, "allocation failed\n");
+		exit(1);
+	}
+}
+
+/* ---------------------------------------------------------------- 2D */
+
+/* x slopes of row jj into s; zero on (and beyond) the wall rows */
+static inline __attribute__((always_inline))
+void Slope_Row_X(int limiter, const real *T, int jj, int nx, int ny, real *s)
+{
+	if (jj <= 0 || jj >= nx-1) {
+		for (int k = 0; k < ny; k++)
+			s[k] = 0;
+		return;
+	}
+	const real *Tm = T + (long)(jj-1)*ny;
+	const real *Tc = T + (long)jj*ny;
+	const real *Tp = T + (long)(jj+1)*ny;
+	for (int k = 0; k < ny; k++)
+		s[k] = Limit(limiter, Tc[k] - Tm[k], Tp[k] - Tc[k]);
+}
+
+static inline __attribute__((always_inline))
+void Slope_Row_Y(int limiter, const real *Tc, int ny, real *s)
+{
+	s[0] = 0;
+	for (int k = 1; k < ny-1; k++)
+		s[k] = Limit(limiter, Tc[k] - Tc[k-1], Tc[k+1] - Tc[k]);
+	s[ny-1] = 0;
+}
+
+/*
+   dt*L for cell k of a row: Tw/Tc/Te are the rows j-1, j, j+1 (Tc on
+   the walls) with their x slopes sw/sc/se, sy the y slopes of row j and
+   kb/kt the bottom/top neighbour (k itself on the walls).  The walls use
+   the same dF/dx = 0 and mirrored diffusion as Step_2D_Row.
+*/
+static inline __attribute__((always_inline))
+double Muscl_Cell(const struct Kernel_2D *kn, int flux,
+		  const real *Tw, const real *Tc, const real *Te,
+		  const real *sw, const real *sc, const real *se, const real *sy,
+		  int k, int kb, int kt, int west_wall, int east_wall, int bottom_wall, int top_wall)
+{
+	real h = 0.5;
+	real Fl = Riemann_Flux_Speed(flux, kn->u, kn->su, Tw[k] + h*sw[k], Tc[k] - h*sc[k]);
+	real Fr = Riemann_Flux_Speed(flux, kn->u, kn->su, Tc[k] + h*sc[k], Te[k] - h*se[k]);
+	real Wb = Riemann_Flux_Speed(flux, kn->v, kn->sv, Tc[kb] + h*sy[kb], Tc[k] - h*sy[k]);
+	real Wt = Riemann_Flux_Speed(flux, kn->v, kn->sv, Tc[k] + h*sy[k], Tc[kt] - h*sy[kt]);
+
+	if (west_wall)
+		Fl = Fr;
+	if (east_wall)
+		Fr = Fl;
+	if (bottom_wall)
+		Wb = Wt;
+	if (top_wall)
+		Wt = Wb;
+
+	double D = kn->kd*(Tw[k] + Te[k] + Tc[kb] + Tc[kt] - 4*Tc[k]);
+	return -(kn->dtdx*(Fr - Fl)) - (kn->dtdy*(Wt - Wb)) + kn->dt*D;
+}
+
+/* Tn = c0*B + c1*(Tc + dt*L) along one row, bottom and top wall cells peeled */
+static inline __attribute__((always_inline))
+void Muscl_Row(const struct Kernel_2D *kn, int flux,
+	       const real *Tw, const real *Tc, const real *Te,
+	       const real *sw, const real *sc, const real *se, const real *sy,
+	       const real *B, real *Tn, int ny, double c0, double c1, int ww, int ew)
+{
+	Tn[0] = c0*B[0] + c1*(Tc[0] + Muscl_Cell(kn, flux, Tw, Tc, Te, sw, sc, se, sy,
+						  0, 0, 1, ww, ew, 1, 0));
+	for (int k = 1; k < ny-1; k++) {
+		Tn[k] = c0*B[k] + c1*(Tc[k] + Muscl_Cell(kn, flux, Tw, Tc, Te, sw, sc, se, sy,
+							  k, k-1, k+1, ww, ew, 0, 0));
+	}
+	int k = ny-1;
+	Tn[k] = c0*B[k] + c1*(Tc[k] + Muscl_Cell(kn, flux, Tw, Tc, Te, sw, sc, se, sy,
+						  k, k-1, k, ww, ew, 0, 1));
+}
+
+/* dst = c0*base + c1*(src + dt*L(src)) */
+static inline __attribute__((always_inline))
+void Stage_2D_Body(const struct Kernel_2D *kn, const real *src, const real *base, real *dst,
+		   double c0, double c1, int flux, int limiter)
+{
+	int nx = kn->nx;
+	int ny = kn->ny;
+
+	/* x slopes of rows j-1, j, j+1; a thread's rows are consecutive, so
+	   only the j+1 row is new when the window moves on */
+	real *sw = kn->scratch + (long)omp_get_thread_num()*4*ny;
+	real *sc = sw + ny;
+	real *se = sc + ny;
+	real *sy = se + ny;
+	int last = -2;
+
+	#pragma omp for schedule(static)
+	for (int j = 0; j < nx; j++) {
+		if (j == last + 1) {
+			real *tmp = sw;
+			sw = sc;
+			sc = se;
+			se = tmp;
+			Slope_Row_X(limiter, src, j+1, nx, ny, se);
+		} else {
+			Slope_Row_X(limiter, src, j-1, nx, ny, sw);
+			Slope_Row_X(limiter, src, j, nx, ny, sc);
+			Slope_Row_X(limiter, src, j+1, nx, ny, se);
+		}
+		last = j;
+
+		const real *Tc = src + (long)j*ny;
+		const real *Tw = (j == 0) ? Tc : Tc - ny;
+		const real *Te = (j == nx-1) ? Tc : Tc + ny;
+		const real *B = base + (long)j*ny;
+		real *Tn = dst + (long)j*ny;
+		Slope_Row_Y(limiter, Tc, ny, sy);
+
+		/* the wall flags are constants on the inside rows */
+		if (j == 0 || j == nx-1)
+			Muscl_Row(kn, flux, Tw, Tc, Te, sw, sc, se, sy, B, Tn, ny, c0, c1, j == 0, j == nx-1);
+		else
+			Muscl_Row(kn, flux, Tw, Tc, Te, sw, sc, se, sy, B, Tn, ny, c0, c1, 0, 0);
+	}
+}
+
+typedef void (*Stage_2D_Fn)(const struct Kernel_2D *kn, const real *src, const real *base,
+			    real *dst, double c0, double c1);
+
+#define MUSCL_2D(FLUX, NAME)                                                              \
+static void Stage_2D_##NAME(const struct Kernel_2D *kn, const real *src, const real *base, \
+			    real *dst, double c0, double c1)                              \
+{                                                                                         \
+	LIMITER_SWITCH(Stage_2D_Body, kn, src, base, dst, c0, c1, FLUX)                   \
+}
+RIEMANN_SCHEMES(MUSCL_2D)
+
+#define MUSCL_2D_ENTRY(FLUX, NAME) [FLUX] = Stage_2D_##NAME,
+static const Stage_2D_Fn stage_2d[NUM_FLUX_SCHEMES] = {
+	RIEMANN_SCHEMES(MUSCL_2D_ENTRY)
+};
+
+/* SSP-RK2 / RK3 in Shu-Osher form; every stage is one "omp for" */
+static void Muscl_Step_2D(const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	Stage_2D_Fn Stage_2D = stage_2d[kn->flux];
+	real *s = kn->stage;
+
+	switch (kn->rk) {
+	case 1:
+		Stage_2D(kn, T, T, Tnew, 0.0, 1.0);
+		break;
+	case 2:
+		Stage_2D(kn, T, T, s, 0.0, 1.0);
+		Stage_2D(kn, s, T, Tnew, 0.5, 0.5);
+		break;
+	default:
+		Stage_2D(kn, T, T, Tnew, 0.0, 1.0);
+		Stage_2D(kn, Tnew, T, s, 0.75, 0.25);
+		Stage_2D(kn, s, T, Tnew, 1.0/3.0, 2.0/3.0);
+		break;
+	}
+}
+
+void Muscl_2D_Init(struct Kernel_2D *k, const struct Params *p)
+{
+	k->limiter = p->limiter;
+	k->rk = p->rk;
+	k->step = Muscl_Step_2D;
+	k->region = NULL;
+	k->stage = Field_Alloc(p, (long)k->nx*k->ny);
+	if (!k->stage) {
+		fprintf(stderr, "allocation failed\n");
+		exit(1);
+	}
+	k->scratch = Work_Alloc((long)p->np*4*k->ny*sizeof(real));
+}
@@ -0,0 +1,29 @@
+#ifndef MUSCL_H
+#define MUSCL_H
+
+#include "solver.h"
+
+/*
+   Second-order MUSCL reconstruction with SSP Runge-Kutta time stepping
+   (limiter=minmod|vanleer|mc, rk=1|2|3).
+
+   Each interface flux is the chosen Riemann solver applied to the
+   limited piecewise-linear states on either side,
+
+       uL = u[j-1] + s[j-1]/2,   uR = u[j] - s[j]/2,
+
+   with the slope s from the left and right differences of the cell.
+   The wall cells keep zero slope and the same wall treatment as the
+   first-order kernels.  rk=2 and rk=3 are the two- and three-stage
+   strong-stability-preserving schemes of Shu and Osher; limiter=none
+   with rk > 1 gives first-order fluxes with RK time stepping.
+
+   Muscl_*_Init replaces the kernel functions, so the time loops,
+   adaptive dt and snapshots drive it unchanged.  Not available with
+   time_block > 1, the SIMD backends or main_mpi.
+*/
+
+void Muscl_1D_Init(struct Kernel_1D *k, const struct Params *p);
+void Muscl_2D_Init(struct Kernel_2D *k, const struct Params *p);
+
+#endif
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Error against wall-clock time: first-order Rusanov against MUSCL +
+# SSP-RK on a ladder of 2D grids (make first).
+#   ./muscl_bench.sh [extra key=value ...]
+# All runs use adaptive dt at the same CFL number; read off the grid at
+# which each scheme reaches a given error and what it cost.
+
+RUN="./main configs/2d_a_d.cfg debug=0 t_final=0.25 adaptive=1 cfl=0.4"
+
+run() {
+	name=$1
+	shift
+	for n in 50 100 200 400 800; do
+		$RUN nx=$n ny=$n "$@" | awk -v name="$name" -v n=$n '
+			/Total error/ { err = $3 }
+			/steps in/ { t = $4 }
+			END { printf("%-16s %5d  error %-12g %10g s\n", name, n, err, t) }'
+	done
+}
+
+run "first order" "$@"
+run "minmod rk2" limiter=minmod rk=2 "$@"
+run "vanleer rk2" limiter=vanleer rk=2 "$@"
+run "mc rk2" limiter=mc rk=2 "$@"
+run "mc rk3" limiter=mc rk=3 "$@"
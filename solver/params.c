@@ -0,0 +1,569 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include "params.h"
+#include "simd.h"
+#include "amr.h"
+
+enum { PARAM_INT, PARAM_DOUBLE, PARAM_FLUX, PARAM_SIMD, PARAM_OUTPUT, PARAM_LIMITER, PARAM_DIFFUSION,
+       PARAM_SPLITTING, PARAM_STRING };
+
+struct Param_Entry {
+	const char *key;
+	int type;
+	size_t offset;
+	size_t size;            /* PARAM_STRING: the buffer, with its '\0'; else 0 */
+};
+
+#define STRING_PARAM(name) PARAM_STRING, offsetof(struct Params, name), sizeof(((struct Params*)0)->name)
+
+static const struct Param_Entry param_table[] = {
+	{ "dim",              PARAM_INT,    offsetof(struct Params, dim), 0 },
+	{ "nx",               PARAM_INT,    offsetof(struct Params, nx), 0 },
+	{ "ny",               PARAM_INT,    offsetof(struct Params, ny), 0 },
+	{ "lx",               PARAM_DOUBLE, offsetof(struct Params, lx), 0 },
+	{ "ly",               PARAM_DOUBLE, offsetof(struct Params, ly), 0 },
+	{ "u",                PARAM_DOUBLE, offsetof(struct Params, u), 0 },
+	{ "v",                PARAM_DOUBLE, offsetof(struct Params, v), 0 },
+	{ "alpha",            PARAM_DOUBLE, offsetof(struct Params, alpha), 0 },
+	{ "dt",               PARAM_DOUBLE, offsetof(struct Params, dt), 0 },
+	{ "cfl",              PARAM_DOUBLE, offsetof(struct Params, cfl), 0 },
+	{ "adaptive",         PARAM_INT,    offsetof(struct Params, adaptive), 0 },
+	{ "t_final",          PARAM_DOUBLE, offsetof(struct Params, t_final), 0 },
+	{ "max_timesteps",    PARAM_INT,    offsetof(struct Params, max_timesteps), 0 },
+	{ "np",               PARAM_INT,    offsetof(struct Params, np), 0 },
+	{ "pin",              PARAM_INT,    offsetof(struct Params, pin), 0 },
+	{ "huge_pages",       PARAM_INT,    offsetof(struct Params, huge_pages), 0 },
+	{ "flux",             PARAM_FLUX,   offsetof(struct Params, flux), 0 },
+	{ "rusanov_speed",    PARAM_DOUBLE, offsetof(struct Params, rusanov_speed), 0 },
+	{ "limiter",          PARAM_LIMITER, offsetof(struct Params, limiter), 0 },
+	{ "rk",               PARAM_INT,    offsetof(struct Params, rk), 0 },
+	{ "diffusion",        PARAM_DIFFUSION, offsetof(struct Params, diffusion), 0 },
+	{ "splitting",        PARAM_SPLITTING, offsetof(struct Params, splitting), 0 },
+	{ "mg_tol",           PARAM_DOUBLE, offsetof(struct Params, mg_tol), 0 },
+	{ "mg_cycles",        PARAM_INT,    offsetof(struct Params, mg_cycles), 0 },
+	{ "simd",             PARAM_SIMD,   offsetof(struct Params, simd), 0 },
+	{ "time_block",       PARAM_INT,    offsetof(struct Params, time_block), 0 },
+	{ "tile_x",           PARAM_INT,    offsetof(struct Params, tile_x), 0 },
+	{ "tile_y",           PARAM_INT,    offsetof(struct Params, tile_y), 0 },
+	{ "slab",             PARAM_INT,    offsetof(struct Params, slab), 0 },
+	{ "steal",            PARAM_INT,    offsetof(struct Params, steal), 0 },
+	{ "sweep_u",          STRING_PARAM(sweep_u) },
+	{ "sweep_v",          STRING_PARAM(sweep_v) },
+	{ "sweep_alpha",      STRING_PARAM(sweep_alpha) },
+	{ "active_tile",      PARAM_INT,    offsetof(struct Params, active_tile), 0 },
+	{ "active_eps",       PARAM_DOUBLE, offsetof(struct Params, active_eps), 0 },
+	{ "amr_levels",       PARAM_INT,    offsetof(struct Params, amr_levels), 0 },
+	{ "amr_block",        PARAM_INT,    offsetof(struct Params, amr_block), 0 },
+	{ "amr_threshold",    PARAM_DOUBLE, offsetof(struct Params, amr_threshold), 0 },
+	{ "amr_regrid",       PARAM_INT,    offsetof(struct Params, amr_regrid), 0 },
+	{ "pulse_x0",         PARAM_DOUBLE, offsetof(struct Params, pulse_x0), 0 },
+	{ "pulse_x1",         PARAM_DOUBLE, offsetof(struct Params, pulse_x1), 0 },
+	{ "pulse_y0",         PARAM_DOUBLE, offsetof(struct Params, pulse_y0), 0 },
+	{ "pulse_y1",         PARAM_DOUBLE, offsetof(struct Params, pulse_y1), 0 },
+	{ "pulse",            PARAM_DOUBLE, offsetof(struct Params, pulse), 0 },
+	{ "background",       PARAM_DOUBLE, offsetof(struct Params, background), 0 },
+	{ "output",           PARAM_OUTPUT, offsetof(struct Params, output), 0 },
+	{ "snapshot_every",   PARAM_INT,    offsetof(struct Params, snapshot_every), 0 },
+	{ "snapshot_dt",      PARAM_DOUBLE, offsetof(struct Params, snapshot_dt), 0 },
+	{ "checkpoint_every", PARAM_INT,    offsetof(struct Params, checkpoint_every), 0 },
+	{ "checkpoint",       STRING_PARAM(checkpoint) },
+	{ "restart",          STRING_PARAM(restart) },
+	{ "progress",         PARAM_DOUBLE, offsetof(struct Params, progress), 0 },
+	{ "prof_trace",       STRING_PARAM(prof_trace) },
+	{ "prof_counters",    PARAM_INT,    offsetof(struct Params, prof_counters), 0 },
+	{ "debug",            PARAM_INT,    offsetof(struct Params, debug), 0 },
+};
+
+#define NUM_PARAMS (sizeof(param_table)/sizeof(param_table[0]))
+
+static const char *flux_names[] = { "upwind", "central", "rusanov", "hll", "roe" };
+static const char *simd_names[] = { "off", "auto", "scalar", "avx2", "avx512", "sve" };
+static const char *output_names[] = { "binary", "text" };
+static const char *limiter_names[] = { "none", "minmod", "vanleer", "mc" };
+static const char *diffusion_names[] = { "explicit", "cn", "be" };
+static const char *splitting_names[] = { "lie", "strang" };
+
+#define NUM_NAMES(a) ((int)(sizeof(a)/sizeof(a[0])))
+
+const char *Flux_Name(int flux)
+{
+	if (flux < 0 || flux >= NUM_NAMES(flux_names))
+		return "unknown";
+	return flux_names[flux];
+}
+
+const char *Simd_Name(int simd)
+{
+	if (simd < 0 || simd >= NUM_NAMES(simd_names))
+		return "unknown";
+	return simd_names[simd];
+}
+
+const char *Output_Name(int output)
+{
+	if (output < 0 || output >= NUM_NAMES(output_names))
+		return "unknown";
+	return output_names[output];
+}
+
+const char *Limiter_Name(int limiter)
+{
+	if (limiter < 0 || limiter >= NUM_NAMES(limiter_names))
+		return "unknown";
+	return limiter_names[limiter];
+}
+
+const char *Diffusion_Name(int diffusion)
+{
+	if (diffusion < 0 || diffusion >= NUM_NAMES(diffusion_names))
+		return "unknown";
+	return diffusion_names[diffusion];
+}
+
+const char *Splitting_Name(int splitting)
+{
+	if (splitting < 0 || splitting >= NUM_NAMES(splitting_names))
+		return "unknown";
+	return splitting_names[splitting];
+}
+
+static int Lookup(const char **names, int count, const char *value)
+{
+	for (int i = 0; i < count; i++) {
+		if (strcmp(value, names[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+/* defaults are the old 2d_a_d/main.c #defines */
+void Params_Default(struct Params *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->dim = 2;
+	p->nx = 800;
+	p->ny = 800;
+	p->lx = 1.0;
+	p->ly = 1.0;
+	p->u = 0.5;
+	p->v = 0.25;
+	p->alpha = 0.000024;
+	p->dt = 0.0001;
+	p->cfl = 0.0;
+	p->t_final = 1.0;
+	p->max_timesteps = 10000;
+	p->np = 8;
+	p->pin = 0;
+	p->huge_pages = 1;
+	p->flux = FLUX_RUSANOV;
+	p->rusanov_speed = 0.0;
+	p->limiter = LIMITER_NONE;
+	p->rk = 1;
+	p->diffusion = DIFFUSION_EXPLICIT;
+	p->splitting = SPLIT_STRANG;
+	p->mg_tol = 1e-5;
+	p->mg_cycles = 30;
+	p->simd = SIMD_OFF;
+	p->time_block = 1;
+	p->tile_x = 32;
+	p->tile_y = 1024;
+	p->slab = 0;
+	p->steal = 0;
+	p->active_tile = 0;
+	p->active_eps = 0.0;
+	p->amr_levels = 0;
+	p->amr_block = 16;
+	p->amr_threshold = 0.01;
+	p->amr_regrid = 4;
+	p->pulse_x0 = 0.1;
+	p->pulse_x1 = 0.2;
+	p->pulse_y0 = 0.1;
+	p->pulse_y1 = 0.2;
+	p->pulse = 1.0;
+	p->background = 0.0;
+	p->output = OUTPUT_BINARY;
+	strcpy(p->checkpoint, "checkpoint.chk");
+	p->progress = 0.0;
+	strcpy(p->prof_trace, "prof_trace.json");
+	p->prof_counters = 0;
+	p->debug = 1;
+}
+
+int Params_Set(struct Params *p, const char *key, const char *value)
+{
+	for (size_t i = 0; i < NUM_PARAMS; i++) {
+		const struct Param_Entry *e = &param_table[i];
+		if (strcmp(key, e->key) != 0)
+			continue;
+
+		char *end;
+		char *field = (char*)p + e->offset;
+		switch (e->type) {
+		case PARAM_INT: {
+			long val = strtol(value, &end, 10);
+			if (end == value || *end != '\0') {
+				fprintf(stderr, "bad integer for %s: '%s'\n", key, value);
+				return -1;
+			}
+			*(int*)field = (int)val;
+			return 0;
+		}
+		case PARAM_DOUBLE: {
+			double val = strtod(value, &end);
+			if (end == value || *end != '\0') {
+				fprintf(stderr, "bad number for %s: '%s'\n", key, value);
+				return -1;
+			}
+			*(double*)field = val;
+			return 0;
+		}
+		case PARAM_FLUX: {
+			int val = Lookup(flux_names, NUM_NAMES(flux_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown flux scheme '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_SIMD: {
+			int val = Lookup(simd_names, NUM_NAMES(simd_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown simd backend '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_OUTPUT: {
+			int val = Lookup(output_names, NUM_NAMES(output_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown output format '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_LIMITER: {
+			int val = Lookup(limiter_names, NUM_NAMES(limiter_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown limiter '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_DIFFUSION: {
+			int val = Lookup(diffusion_names, NUM_NAMES(diffusion_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown diffusion scheme '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_SPLITTING: {
+			int val = Lookup(splitting_names, NUM_NAMES(splitting_names), value);
+			if (val < 0) {
+				fprintf(stderr, "unknown splitting '%s'\n", value);
+				return -1;
+			}
+			*(int*)field = val;
+			return 0;
+		}
+		case PARAM_STRING:
+			if (strlen(value) >= e->size) {
+				fprintf(stderr, "%s too long: %zu characters, at most %zu\n",
+					key, strlen(value), e->size - 1);
+				return -1;
+			}
+			strcpy(field, value);
+			return 0;
+		}
+	}
+	fprintf(stderr, "unknown parameter '%s'\n", key);
+	return -1;
+}
+
+static char *Trim(char *s)
+{
+	while (isspace((unsigned char)*s))
+		s++;
+	char *end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1]))
+		end--;
+	*end = '\0';
+	return s;
+}
+
+/* "key = value" per line, '#' starts a comment */
+int Params_Read_File(struct Params *p, const char *filename)
+{
+	FILE *fp = fopen(filename, "r");
+	if (!fp) {
+		fprintf(stderr, "cannot open config file %s\n", filename);
+		return -1;
+	}
+
+	/* lines of any length; Params_Set rejects values that do not fit */
+	char *line = NULL;
+	size_t cap = 0;
+	int lineno = 0;
+	int err = 0;
+	while (getline(&line, &cap, fp) != -1) {
+		lineno++;
+		char *hash = strchr(line, '#');
+		if (hash)
+			*hash = '\0';
+		char *s = Trim(line);
+		if (*s == '\0')
+			continue;
+
+		char *eq = strchr(s, '=');
+		if (!eq) {
+			fprintf(stderr, "%s:%d: expected key = value\n", filename, lineno);
+			err = -1;
+			continue;
+		}
+		*eq = '\0';
+		if (Params_Set(p, Trim(s), Trim(eq + 1)) != 0) {
+			fprintf(stderr, "%s:%d: ignored\n", filename, lineno);
+			err = -1;
+		}
+	}
+	free(line);
+	fclose(fp);
+	return err;
+}
+
+/* Arguments are applied in order: "key=value" sets one parameter, anything
+   else is read as a config file, so later arguments override earlier ones. */
+int Params_Parse_Args(struct Params *p, int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++) {
+		if (!strchr(argv[i], '=')) {
+			if (Params_Read_File(p, argv[i]) != 0)
+				return -1;
+			continue;
+		}
+		/* split a copy of the whole argument, never a truncated one */
+		char *arg = strdup(argv[i]);
+		if (!arg) {
+			fprintf(stderr, "out of memory\n");
+			return -1;
+		}
+		char *eq = strchr(arg, '=');
+		*eq = '\0';
+		int err = Params_Set(p, Trim(arg), Trim(eq + 1));
+		free(arg);
+		if (err != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* the largest |value| of a sweep_* list, or |base| without one; the
+   members of an ensemble share dt, so it is set by the fastest */
+static double Sweep_Max(const char *list, double base)
+{
+	double m = 0.0;
+	char *end;
+
+	if (!list[0])
+		return fabs(base);
+	while (*list) {
+		double v = fabs(strtod(list, &end));
+		if (end == list)
+			break;
+		if (v > m)
+			m = v;
+		list = *end == ',' ? end + 1 : end;
+	}
+	return m;
+}
+
+/* fill in derived values and reject settings the solvers cannot run */
+int Params_Check(struct Params *p)
+{
+	if (p->dim != 1 && p->dim != 2) {
+		fprintf(stderr, "dim must be 1 or 2\n");
+		return -1;
+	}
+	if (p->dim == 1)
+		p->ny = 1;
+	if (p->nx < 2 || (p->dim == 2 && p->ny < 2)) {
+		fprintf(stderr, "grid too small: %d x %d\n", p->nx, p->ny);
+		return -1;
+	}
+	if (p->adaptive) {
+		if (p->cfl <= 0.0) {
+			fprintf(stderr, "adaptive=1 needs the target cfl\n");
+			return -1;
+		}
+		if (p->time_block > 1 || p->snapshot_dt > 0.0 || p->checkpoint_every > 0 || p->restart[0]) {
+			fprintf(stderr, "adaptive=1 does not support time_block, snapshot_dt or checkpoints\n");
+			return -1;
+		}
+	} else if (p->dt <= 0.0) {
+		double speed = Sweep_Max(p->sweep_u, p->u);
+		if (p->cfl <= 0.0 || speed == 0.0) {
+			fprintf(stderr, "need dt, or cfl with a nonzero u\n");
+			return -1;
+		}
+		p->dt = p->cfl*(p->lx/p->nx) / speed;
+	}
+	if (p->np < 1)
+		p->np = 1;
+	if ((p->simd = Simd_Resolve(p->simd)) < 0)
+		return -1;
+	if (p->time_block < 1)
+		p->time_block = 1;
+	if (p->tile_x < 1 || p->tile_y < 1) {
+		fprintf(stderr, "tile_x and tile_y must be positive\n");
+		return -1;
+	}
+	if (p->rk < 1 || p->rk > 3) {
+		fprintf(stderr, "rk must be 1, 2 or 3\n");
+		return -1;
+	}
+	if ((p->limiter != LIMITER_NONE || p->rk > 1) && (p->time_block > 1 || p->simd != SIMD_OFF)) {
+		fprintf(stderr, "limiter and rk > 1 do not support time_block or simd\n");
+		return -1;
+	}
+	if (p->diffusion == DIFFUSION_BE && p->dim != 2) {
+		fprintf(stderr, "diffusion=be is 2D only\n");
+		return -1;
+	}
+	if (p->mg_tol <= 0.0 || p->mg_cycles < 1) {
+		fprintf(stderr, "mg_tol must be > 0 and mg_cycles >= 1\n");
+		return -1;
+	}
+	if (p->diffusion != DIFFUSION_EXPLICIT && p->time_block > 1) {
+		fprintf(stderr, "diffusion=%s does not support time_block\n", Diffusion_Name(p->diffusion));
+		return -1;
+	}
+	if ((p->sweep_u[0] || p->sweep_v[0] || p->sweep_alpha[0])
+	    && (p->adaptive || p->time_block > 1 || p->limiter != LIMITER_NONE || p->rk > 1
+		|| p->diffusion != DIFFUSION_EXPLICIT || p->simd != SIMD_OFF || p->active_tile > 0
+		|| p->amr_levels > 0 || p->snapshot_every > 0 || p->snapshot_dt > 0.0
+		|| p->checkpoint_every > 0 || p->restart[0] || p->slab || p->steal)) {
+		fprintf(stderr, "sweep_* runs the plain fixed-dt explicit step only\n");
+		return -1;
+	}
+	if (p->slab && (p->dim != 1 || p->adaptive || p->limiter != LIMITER_NONE || p->rk > 1
+			|| p->diffusion != DIFFUSION_EXPLICIT)) {
+		fprintf(stderr, "slab=1 is for the plain fixed-dt 1D step only\n");
+		return -1;
+	}
+	if (p->slab && p->nx < 2*p->np) {
+		fprintf(stderr, "slab=1 needs at least 2 cells per thread\n");
+		return -1;
+	}
+	if (p->steal && (p->dim != 2 || p->time_block > 1 || p->limiter != LIMITER_NONE || p->rk > 1
+			 || p->diffusion != DIFFUSION_EXPLICIT || p->amr_levels > 0)) {
+		fprintf(stderr, "steal=1 is for the plain explicit 2D step only\n");
+		return -1;
+	}
+	if (p->rusanov_speed < 0.0) {
+		fprintf(stderr, "rusanov_speed must not be negative\n");
+		return -1;
+	}
+	if (p->active_tile < 0 || p->active_eps < 0.0) {
+		fprintf(stderr, "active_tile and active_eps must not be negative\n");
+		return -1;
+	}
+	if (p->active_tile > 0 && (p->dim != 2 || p->adaptive || p->time_block > 1
+				   || p->limiter != LIMITER_NONE || p->rk > 1
+				   || p->diffusion != DIFFUSION_EXPLICIT || p->amr_levels > 0)) {
+		fprintf(stderr, "active_tile > 0 is for the plain fixed-dt 2D step only\n");
+		return -1;
+	}
+	if (p->amr_levels < 0 || p->amr_levels >= AMR_MAX_LEVELS) {
+		fprintf(stderr, "amr_levels must be 0 to %d\n", AMR_MAX_LEVELS - 1);
+		return -1;
+	}
+	if (p->amr_levels > 0) {
+		int h = p->amr_block / 2;
+		double r = p->alpha*p->dt*(1 << p->amr_levels)*p->nx*p->nx/(p->lx*p->lx);
+		if (p->dim != 2 || p->adaptive || p->time_block > 1 || p->limiter != LIMITER_NONE
+		    || p->rk > 1 || p->diffusion != DIFFUSION_EXPLICIT || p->snapshot_every > 0
+		    || p->snapshot_dt > 0.0 || p->checkpoint_every > 0 || p->restart[0]) {
+			fprintf(stderr, "amr_levels > 0 is for the plain explicit 2D step only\n");
+			return -1;
+		}
+		if (p->amr_block < 4 || p->amr_block % 2 || p->nx % h || p->ny % h) {
+			fprintf(stderr, "amr_block must be even, >= 4, and nx, ny multiples of amr_block/2\n");
+			return -1;
+		}
+		if (p->amr_regrid < 1)
+			p->amr_regrid = 1;
+		/* dt/2^l on a 2^l finer grid: the diffusion number doubles per level */
+		if (r > 0.25) {
+			fprintf(stderr, "dt too large for diffusion on the finest amr level\n");
+			return -1;
+		}
+	}
+	if (p->snapshot_every < 0 || p->snapshot_dt < 0.0 || p->checkpoint_every < 0) {
+		fprintf(stderr, "snapshot and checkpoint intervals must not be negative\n");
+		return -1;
+	}
+	if (p->progress < 0.0) {
+		fprintf(stderr, "progress must not be negative\n");
+		return -1;
+	}
+	return 0;
+}
+
+void Params_Print(const struct Params *p, FILE *fp)
+{
+	fprintf(fp, "dim %d  nx %d  ny %d  lx %g  ly %g\n", p->dim, p->nx, p->ny, p->lx, p->ly);
+	fprintf(fp, "u %g  v %g  alpha %g  flux %s  simd %s\n", p->u, p->v, p->alpha,
+		Flux_Name(p->flux), Simd_Name(p->simd));
+	if (p->rusanov_speed > 0.0)
+		fprintf(fp, "rusanov_speed %g\n", p->rusanov_speed);
+	if (p->limiter != LIMITER_NONE || p->rk > 1)
+		fprintf(fp, "limiter %s  rk %d\n", Limiter_Name(p->limiter), p->rk);
+	if (p->diffusion != DIFFUSION_EXPLICIT)
+		fprintf(fp, "diffusion %s  splitting %s\n", Diffusion_Name(p->diffusion),
+			Splitting_Name(p->splitting));
+	if (p->diffusion == DIFFUSION_BE)
+		fprintf(fp, "mg_tol %g  mg_cycles %d\n", p->mg_tol, p->mg_cycles);
+	if (p->adaptive)
+		fprintf(fp, "adaptive dt, cfl %g  t_final %g  max_timesteps %d  np %d  output %s\n", p->cfl,
+			p->t_final, p->max_timesteps, p->np, Output_Name(p->output));
+	else
+		fprintf(fp, "dt %g  t_final %g  max_timesteps %d  np %d  output %s\n", p->dt, p->t_final,
+			p->max_timesteps, p->np, Output_Name(p->output));
+	if (p->pin || p->huge_pages)
+		fprintf(fp, "pin %d  huge_pages %d\n", p->pin, p->huge_pages);
+	if (p->dim == 2 && p->time_block > 1)
+		fprintf(fp, "time_block %d  tile %d x %d\n", p->time_block, p->tile_x, p->tile_y);
+	if (p->slab)
+		fprintf(fp, "slab stepper, %d cells per thread\n", p->nx / p->np);
+	if (p->steal)
+		fprintf(fp, "work stealing over %d x %d tiles\n", p->tile_x, p->tile_y);
+	if (p->sweep_u[0] || p->sweep_v[0] || p->sweep_alpha[0])
+		fprintf(fp, "sweep_u %s  sweep_v %s  sweep_alpha %s\n", p->sweep_u[0] ? p->sweep_u : "-",
+			p->sweep_v[0] ? p->sweep_v : "-", p->sweep_alpha[0] ? p->sweep_alpha : "-");
+	if (p->active_tile > 0)
+		fprintf(fp, "active_tile %d  active_eps %g\n", p->active_tile, p->active_eps);
+	if (p->amr_levels > 0)
+		fprintf(fp, "amr_levels %d  amr_block %d  amr_threshold %g  amr_regrid %d\n", p->amr_levels,
+			p->amr_block, p->amr_threshold, p->amr_regrid);
+	if (p->snapshot_every > 0 || p->snapshot_dt > 0.0)
+		fprintf(fp, "snapshot_every %d  snapshot_dt %g\n", p->snapshot_every, p->snapshot_dt);
+	if (p->checkpoint_every > 0)
+		fprintf(fp, "checkpoint_every %d  checkpoint %s\n", p->checkpoint_every, p->checkpoint);
+	if (p->restart[0])
+		fprintf(fp, "restart from %s\n", p->restart);
+	if (p->progress > 0.0)
+		fprintf(fp, "progress every %g s\n", p->progress);
+#ifdef USE_PROF
+	fprintf(fp, "prof_trace %s  prof_counters %d\n", p->prof_trace[0] ? p->prof_trace : "-",
+		p->prof_counters);
+#endif
+}
@@ -0,0 +1,147 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdio.h>
+
+/* Run-time grid and physics parameters.  They used to be #defines in each
+   solver (NX, NY, DT, T_FINAL, NP, alpha ...); now they are read from a
+   config file and/or "key=value" arguments on the command line. */
+
+#define PARAM_PATH_LEN 256
+#define PARAM_LIST_LEN 4096     /* the sweep_* lists */
+
+enum Flux_Scheme {
+	FLUX_UPWIND,
+	FLUX_CENTRAL,
+	FLUX_RUSANOV,
+	FLUX_HLL,
+	FLUX_ROE
+};
+
+enum Limiter {
+	LIMITER_NONE,           /* first order */
+	LIMITER_MINMOD,
+	LIMITER_VANLEER,
+	LIMITER_MC              /* monotonized central */
+};
+
+enum Diffusion_Scheme {
+	DIFFUSION_EXPLICIT,
+	DIFFUSION_CN,           /* Crank-Nicolson (1D), ADI (2D) */
+	DIFFUSION_BE            /* backward Euler, multigrid (2D) */
+};
+
+enum Splitting {
+	SPLIT_LIE,
+	SPLIT_STRANG
+};
+
+enum Simd_Backend {
+	SIMD_OFF,               /* default kernels, double-precision blend */
+	SIMD_AUTO,              /* best backend the CPU supports */
+	SIMD_SCALAR,
+	SIMD_AVX2,
+	SIMD_AVX512,
+	SIMD_SVE
+};
+
+enum Output_Format {
+	OUTPUT_BINARY,          /* .fld files, see field_io.h */
+	OUTPUT_TEXT             /* the old one-line-per-cell .dat/.txt dumps */
+};
+
+struct Params {
+	int dim;                /* 1 or 2 */
+	int nx;                 /* number of X cells */
+	int ny;                 /* number of Y cells (2D only) */
+	double lx;              /* domain length */
+	double ly;              /* domain height */
+	double u;               /* advection speed X */
+	double v;               /* advection speed Y */
+	double alpha;           /* diffusion coefficient */
+	double dt;              /* time step size, 0 = derive it from cfl */
+	double cfl;             /* dt = cfl*dx/|u| when dt is not given */
+	int adaptive;           /* 1 = new dt every step at Courant number cfl */
+	double t_final;         /* final time */
+	int max_timesteps;
+	int np;                 /* number of OpenMP threads */
+	int pin;                /* bind each thread to one CPU */
+	int huge_pages;         /* transparent huge pages for the fields */
+	int flux;               /* enum Flux_Scheme */
+	double rusanov_speed;   /* Rusanov dissipation speed, 0 = local |u|, |v|;
+				   2D flux=rusanov only, ignored otherwise */
+	int limiter;            /* enum Limiter: MUSCL slopes (muscl.h) */
+	int rk;                 /* SSP Runge-Kutta stages: 1, 2 or 3 */
+	int diffusion;          /* enum Diffusion_Scheme (implicit.h, multigrid.h) */
+	int splitting;          /* enum Splitting (split.h) */
+	double mg_tol;          /* multigrid: relative max-norm residual */
+	int mg_cycles;          /* multigrid: V-cycles per solve at most */
+	int simd;               /* enum Simd_Backend */
+
+	/* temporal blocking of the 2D step: time_block steps per tile */
+	int time_block;         /* 1 = plain step-by-step sweep */
+	int tile_x;
+	int tile_y;
+
+	/* persistent-thread 1D stepper (slab.c): one slab per thread,
+	   neighbour flags instead of barriers */
+	int slab;               /* 1 = on */
+
+	/* work-stealing tile scheduler of the 2D loops (sched.c) */
+	int steal;              /* 1 = on, over tile_x x tile_y tiles */
+
+	/* ensemble mode (ensemble.h): comma-separated values, "" = off */
+	char sweep_u[PARAM_LIST_LEN];
+	char sweep_v[PARAM_LIST_LEN];
+	char sweep_alpha[PARAM_LIST_LEN];
+
+	/* active-tile tracking of the 2D step (active.h), 0 = off */
+	int active_tile;        /* tile side in cells */
+	double active_eps;      /* quiet: within active_eps of the background */
+
+	/* block-structured AMR of the 2D step (amr.h), 0 levels = off */
+	int amr_levels;         /* refined levels, each 2x finer */
+	int amr_block;          /* cells per block side */
+	double amr_threshold;   /* refine where neighbouring cells differ more */
+	int amr_regrid;         /* level-0 steps between regrids */
+
+	/* initial condition: square pulse on a constant background */
+	double pulse_x0, pulse_x1;
+	double pulse_y0, pulse_y1;
+	double pulse;
+	double background;
+
+	int output;             /* enum Output_Format */
+
+	/* snapshots during the run (snapshot.h), 0 = off */
+	int snapshot_every;     /* every N steps */
+	double snapshot_dt;     /* every snapshot_dt of simulated time */
+
+	/* checkpoint/restart (checkpoint.h) */
+	int checkpoint_every;   /* steps between checkpoints, 0 = off */
+	char checkpoint[PARAM_PATH_LEN];        /* file the checkpoints go to */
+	char restart[PARAM_PATH_LEN];           /* checkpoint to start from, "" = none */
+
+	double progress;        /* seconds between progress lines (telemetry.h), 0 = off */
+
+	/* instrumentation, make prof only (prof.h) */
+	char prof_trace[PARAM_PATH_LEN];        /* Chrome trace file, "" = none */
+	int prof_counters;      /* 1 = perf_event_open counters per phase */
+
+	int debug;
+};
+
+void Params_Default(struct Params *p);
+int Params_Set(struct Params *p, const char *key, const char *value);
+int Params_Read_File(struct Params *p, const char *filename);
+int Params_Parse_Args(struct Params *p, int argc, char **argv);
+int Params_Check(struct Params *p);
+void Params_Print(const struct Params *p, FILE *fp);
+const char *Flux_Name(int flux);
+const char *Simd_Name(int simd);
+const char *Output_Name(int output);
+const char *Limiter_Name(int limiter);
+const char *Diffusion_Name(int diffusion);
+const char *Splitting_Name(int splitting);
+
+#endif
@@ -0,0 +1,299 @@
+#ifdef USE_PROF
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include "prof.h"
+#include "field_alloc.h"
+
+#define PROF_DEPTH 8
+#define PROF_MAX_EVENTS (1 << 18)       /* trace events kept per thread */
+#define PROF_COUNTERS 4                 /* cycles, instructions, LLC refs, LLC misses */
+
+static const char *phase_names[PROF_PHASES] = {
+	"fluxes", "update", "step", "snapshot", "error", "output", "wait"
+};
+
+struct Prof_Stat {
+	double time;            /* inclusive */
+	double wait;            /* PROF_WAIT inside it */
+	long calls;
+	uint64_t ctr[PROF_COUNTERS];
+};
+
+struct Prof_Event {
+	double t0, t1;
+	int phase;
+};
+
+struct Prof_Frame {
+	int phase;
+	double t0;
+	uint64_t c0[PROF_COUNTERS];
+};
+
+/* one per thread, allocated and first touched by its thread */
+struct Prof_Thread {
+	struct Prof_Stat stat[PROF_PHASES];
+	struct Prof_Frame stack[PROF_DEPTH];
+	int depth;
+	int fd[PROF_COUNTERS];  /* perf group, fd[0] the leader; -1 = no counters */
+	struct Prof_Event *events;
+	long nevents, dropped;
+};
+
+static struct {
+	const struct Params *p;
+	int nthreads;
+	double t0;
+	int counters;           /* counters opened on some thread */
+	struct Prof_Thread **thread;
+} prof;
+
+void Prof_Init(const struct Params *p)
+{
+	prof.p = p;
+	prof.nthreads = p->np;
+	prof.counters = 0;
+	prof.thread = Work_Alloc(p->np*sizeof(*prof.thread));
+	prof.t0 = omp_get_wtime();
+}
+
+static int Open_Counter(uint64_t config, int group)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	/* this thread, any CPU */
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/* closes the open members of a group and marks them all unopened */
+static void Close_Counters(int *fd)
+{
+	for (int i = 0; i < PROF_COUNTERS; i++) {
+		if (fd[i] >= 0)
+			close(fd[i]);
+		fd[i] = -1;
+	}
+}
+
+/* the counter group of the calling thread into fd[]; -1 and all of fd[]
+   -1 if any of them cannot be opened */
+static int Open_Counters(int *fd)
+{
+	static const uint64_t config[PROF_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+	};
+
+	for (int i = 0; i < PROF_COUNTERS; i++)
+		fd[i] = -1;
+	for (int i = 0; i < PROF_COUNTERS; i++) {
+		fd[i] = Open_Counter(config[i], i ? fd[0] : -1);
+		if (fd[i] < 0) {
+			Close_Counters(fd);
+			return -1;
+		}
+	}
+	ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return 0;
+}
+
+static void Read_Counters(const struct Prof_Thread *t, uint64_t *c)
+{
+	uint64_t buf[1 + PROF_COUNTERS];
+
+	if (t->fd[0] < 0 || read(t->fd[0], buf, sizeof(buf)) != sizeof(buf)) {
+		memset(c, 0, PROF_COUNTERS*sizeof(*c));
+		return;
+	}
+	memcpy(c, buf + 1, PROF_COUNTERS*sizeof(*c));
+}
+
+void Prof_Thread_Start(void)
+{
+	int tid = omp_get_thread_num();
+	struct Prof_Thread *t;
+
+	if (tid >= prof.nthreads || prof.thread[tid])
+		return;
+	t = Work_Alloc(sizeof(*t));
+	t->events = Work_Alloc(PROF_MAX_EVENTS*sizeof(*t->events));
+	for (int i = 0; i < PROF_COUNTERS; i++)
+		t->fd[i] = -1;
+	if (prof.p->prof_counters) {
+		if (Open_Counters(t->fd) < 0 && tid == 0)
+			fprintf(stderr, "prof: no perf_event_open counters (perf_event_paranoid?), timers only\n");
+	}
+	prof.thread[tid] = t;
+	if (t->fd[0] >= 0) {
+		#pragma omp atomic write
+		prof.counters = 1;
+	}
+}
+
+/* the calling thread's state, NULL outside Prof_Init..Prof_Finish; the
+   master also outside the parallel region */
+static struct Prof_Thread *Self(void)
+{
+	int tid = omp_get_thread_num();
+
+	if (!prof.thread || tid >= prof.nthreads)
+		return NULL;
+	if (!prof.thread[tid] && omp_get_level() == 0)
+		Prof_Thread_Start();
+	return prof.thread[tid];
+}
+
+void Prof_Begin(int phase)
+{
+	struct Prof_Thread *t = Self();
+
+	if (!t || t->depth == PROF_DEPTH)
+		return;
+	struct Prof_Frame *f = &t->stack[t->depth++];
+	f->phase = phase;
+	if (t->fd[0] >= 0)
+		Read_Counters(t, f->c0);
+	f->t0 = omp_get_wtime();
+}
+
+void Prof_End(int phase)
+{
+	double now = omp_get_wtime();
+	struct Prof_Thread *t = Self();
+
+	if (!t || t->depth == 0 || t->stack[t->depth-1].phase != phase)
+		return;
+	struct Prof_Frame *f = &t->stack[--t->depth];
+	struct Prof_Stat *s = &t->stat[phase];
+
+	s->time += now - f->t0;
+	s->calls++;
+	if (t->fd[0] >= 0) {
+		uint64_t c[PROF_COUNTERS];
+		Read_Counters(t, c);
+		for (int i = 0; i < PROF_COUNTERS; i++)
+			s->ctr[i] += c[i] - f->c0[i];
+	}
+	if (phase == PROF_WAIT && t->depth > 0)
+		t->stat[t->stack[t->depth-1].phase].wait += now - f->t0;
+
+	if (t->nevents < PROF_MAX_EVENTS)
+		t->events[t->nevents++] = (struct Prof_Event){ f->t0, now, phase };
+	else
+		t->dropped++;
+}
+
+static void Write_Trace(const char *path)
+{
+	FILE *fp = fopen(path, "w");
+	int first = 1;
+	long dropped = 0;
+
+	if (!fp) {
+		fprintf(stderr, "prof: cannot write %s\n", path);
+		return;
+	}
+	fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (int i = 0; i < prof.nthreads; i++) {
+		struct Prof_Thread *t = prof.thread[i];
+		if (!t)
+			continue;
+		fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+			"\"args\": {\"name\": \"thread %d\"}}", first ? "" : ",\n", i, i);
+		first = 0;
+		for (long e = 0; e < t->nevents; e++) {
+			const struct Prof_Event *ev = &t->events[e];
+			fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+				"\"ts\": %.3f, \"dur\": %.3f}", phase_names[ev->phase], i,
+				1e6*(ev->t0 - prof.t0), 1e6*(ev->t1 - ev->t0));
+		}
+		dropped += t->dropped;
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+	printf("prof: trace in %s", path);
+	if (dropped)
+		printf(" (%ld events past %d per thread left out)", dropped, PROF_MAX_EVENTS);
+	printf("\n");
+}
+
+void Prof_Finish(FILE *fp)
+{
+	double wall = omp_get_wtime() - prof.t0;
+	int n = 0;
+
+	for (int i = 0; i < prof.nthreads; i++)
+		n += prof.thread[i] != NULL;
+	fprintf(fp, "prof: %d threads, %g s\n", n, wall);
+	fprintf(fp, "%-9s %8s %10s %10s %10s %10s", "phase", "calls", "time mean", "time max",
+		"wait mean", "wait max");
+	if (prof.counters)
+		fprintf(fp, " %7s %11s %9s %9s", "IPC", "LLC miss", "miss %", "GB/s");
+	fprintf(fp, "\n");
+
+	for (int ph = 0; ph < PROF_PHASES; ph++) {
+		double time = 0.0, time_max = 0.0, wait = 0.0, wait_max = 0.0;
+		uint64_t ctr[PROF_COUNTERS] = { 0 };
+		long calls = 0;
+		int used = 0;           /* threads that ran the phase */
+
+		for (int i = 0; i < prof.nthreads; i++) {
+			const struct Prof_Thread *t = prof.thread[i];
+			if (!t)
+				continue;
+			const struct Prof_Stat *s = &t->stat[ph];
+			used += s->calls > 0;
+			time += s->time;
+			wait += s->wait;
+			if (s->time > time_max)
+				time_max = s->time;
+			if (s->wait > wait_max)
+				wait_max = s->wait;
+			if (s->calls > calls)
+				calls = s->calls;
+			for (int c = 0; c < PROF_COUNTERS; c++)
+				ctr[c] += s->ctr[c];
+		}
+		if (!calls)
+			continue;
+		fprintf(fp, "%-9s %8ld %10.4g %10.4g %10.4g %10.4g", phase_names[ph], calls,
+			time / used, time_max, wait / used, wait_max);
+		if (prof.counters)
+			fprintf(fp, " %7.2f %11llu %9.1f %9.3g", ctr[0] ? (double)ctr[1] / ctr[0] : 0.0,
+				(unsigned long long)ctr[3], ctr[2] ? 100.0*ctr[3] / ctr[2] : 0.0,
+				/* a miss moves one line; the threads ran side by side */
+				time_max > 0.0 ? 64.0*ctr[3] / time_max / 1e9 : 0.0);
+		fprintf(fp, "\n");
+	}
+
+	if (prof.p->prof_trace[0])
+		Write_Trace(prof.p->prof_trace);
+
+	for (int i = 0; i < prof.nthreads; i++) {
+		struct Prof_Thread *t = prof.thread[i];
+		if (!t)
+			continue;
+		Close_Counters(t->fd);
+		free(t->events);
+		free(t);
+	}
+	free(prof.thread);
+	prof.thread = NULL;
+}
+
+#endif
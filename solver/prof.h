@@ -0,0 +1,76 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdio.h>
+#include "params.h"
+
+/*
+   Hot-path instrumentation, built with make prof (-DUSE_PROF, main_prof).
+   Without USE_PROF every PROF_* macro below is empty and PROF_BARRIER is
+   a plain "omp barrier", so the normal build carries none of it.
+
+   Every thread times the phases of the step (PROF_BEGIN/PROF_END, which
+   nest) into its own counters, so the hot path takes no locks and shares
+   no cache lines.  The default kernels end their loops with "nowait" and
+   PROF_BARRIER, which times the wait at what used to be the loop's
+   implicit barrier and charges it to the enclosing phase.  With
+   prof_counters=1 each thread also reads a perf_event_open group
+   (cycles, instructions, LLC references and misses) at every phase
+   boundary: two read() calls per phase, so keep it for runs whose phases
+   are long next to a microsecond.
+
+   Prof_Finish prints one table (per phase: calls, time and barrier wait
+   as mean and max over the threads, and with counters IPC, LLC misses
+   and the DRAM traffic they imply) and writes every timed interval as a
+   Chrome trace (chrome://tracing, ui.perfetto.dev) to prof_trace.
+*/
+
+enum Prof_Phase {
+	PROF_FLUXES,            /* Compute_Fluxes_1D */
+	PROF_UPDATE,            /* Update_State_1D */
+	PROF_STEP,              /* the 2D step, or a whole advance */
+	PROF_SNAPSHOT,          /* snapshot and checkpoint copies */
+	PROF_ERROR,             /* error reduction */
+	PROF_OUTPUT,            /* result files */
+	PROF_WAIT,              /* barrier wait, inside the phases above */
+	PROF_PHASES
+};
+
+#ifdef USE_PROF
+
+/* before the parallel region: state for p->np threads */
+void Prof_Init(const struct Params *p);
+
+/* every thread of the parallel region, once: its counters */
+void Prof_Thread_Start(void);
+
+void Prof_Begin(int phase);
+void Prof_End(int phase);
+
+/* after the run: table on fp, trace file, release everything */
+void Prof_Finish(FILE *fp);
+
+#define PROF_INIT(p)            Prof_Init(p)
+#define PROF_THREAD_START()     Prof_Thread_Start()
+#define PROF_BEGIN(phase)       Prof_Begin(phase)
+#define PROF_END(phase)         Prof_End(phase)
+#define PROF_FINISH(fp)         Prof_Finish(fp)
+#define PROF_BARRIER()                          \
+	do {                                    \
+		Prof_Begin(PROF_WAIT);          \
+		_Pragma("omp barrier")          \
+		Prof_End(PROF_WAIT);            \
+	} while (0)
+
+#else
+
+#define PROF_INIT(p)            ((void)0)
+#define PROF_THREAD_START()     ((void)0)
+#define PROF_BEGIN(phase)       ((void)0)
+#define PROF_END(phase)         ((void)0)
+#define PROF_FINISH(fp)         ((void)0)
+#define PROF_BARRIER()          _Pragma("omp barrier")
+
+#endif
+
+#endif
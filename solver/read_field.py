@@ -0,0 +1,72 @@
+"""Reader for the solver's binary field files (.fld), see field_io.h.
+
+    from read_field import read_field
+    f = read_field("resultsT.fld")
+    plt.pcolormesh(f.x, f.y, f["T"].T)
+
+The arrays are numpy memmaps straight onto the file: opening a field
+costs the header parse only, and 2D variables come back as (nx, ny)
+with the x index first, like the solver stores them.
+"""
+
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"SLVFIELD"
+HEADER = struct.Struct("<8sIIIIIIII q ddd")
+VAR = struct.Struct("<16sQQ")
+MAX_VARS = 8
+
+
+class Field:
+    def __init__(self, path):
+        with open(path, "rb") as fp:
+            head = fp.read(HEADER.size + MAX_VARS * VAR.size)
+        (magic, version, header_size, dim, nx, ny, nvars, real_size, _pad,
+         step, time, lx, ly) = HEADER.unpack_from(head)
+        if magic != MAGIC:
+            raise ValueError("%s is not a field file" % path)
+        if version != 1:
+            raise ValueError("%s: unsupported version %d" % (path, version))
+
+        self.path = path
+        self.dim, self.nx, self.ny = dim, nx, ny
+        self.step, self.time = step, time
+        self.lx, self.ly = lx, ly
+        dtype = np.dtype("<f4") if real_size == 4 else np.dtype("<f8")
+
+        self.vars = {}
+        for v in range(nvars):
+            name, count, offset = VAR.unpack_from(head, HEADER.size + v * VAR.size)
+            name = name.rstrip(b"\0").decode()
+            data = np.memmap(path, dtype=dtype, mode="r", offset=offset, shape=(count,))
+            if dim == 2 and count == nx * ny:
+                data = data.reshape(nx, ny)
+            self.vars[name] = data
+
+    def __getitem__(self, name):
+        return self.vars[name]
+
+    @property
+    def x(self):
+        """cell centres in x"""
+        return (np.arange(self.nx) + 0.5) * (self.lx / self.nx)
+
+    @property
+    def y(self):
+        """cell centres in y"""
+        return (np.arange(self.ny) + 0.5) * (self.ly / self.ny)
+
+
+def read_field(path):
+    return Field(path)
+
+
+if __name__ == "__main__":
+    for path in sys.argv[1:]:
+        f = read_field(path)
+        print("%s: %dD %d x %d, step %d, t = %g" % (path, f.dim, f.nx, f.ny, f.step, f.time))
+        for name, data in f.vars.items():
+            print("  %-8s %-12s min %g max %g" % (name, data.shape, data.min(), data.max()))
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""End-to-end regression suite: every scenario against its golden data.
+
+    ./regress.py                  # the quick scenarios (make and make double first)
+    ./regress.py --all            # also the 800x800 2d_a_d run (minutes)
+    ./regress.py 1d_diffusion     # just the named ones
+
+Each scenario runs ./main or ./main_double with output=text in a
+scratch directory and compares the output columns against the golden
+files checked into the repo (the results of the original programs the
+configs were ported from), within |out - golden| <= atol + rtol*|golden|.
+The text files hold %g values, so rtol defaults to a few units in their
+sixth digit; a golden file can carry a larger atol of its own.
+
+Every scenario runs at least --repeat times and until its runs took
+--min_time seconds, and the fastest run counts.  The suite appends the
+wall time and cell updates/s per scenario to
+regress_history.json (with the commit and host).  A scenario whose
+updates/s falls more than --threshold below the median of its last
+--window passing runs on the same host is flagged as a throughput
+regression.  The exit status is 1 when any scenario fails or regresses.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+import numpy as np
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.dirname(HERE)
+
+# 64 swept speeds, 447 characters on the command line
+SWEEP_64 = ",".join("%.4f" % (0.37 + 0.01 * i) for i in range(64))
+
+# name, binary, config, key=value args, [(output, golden, atol)], slow
+SCENARIOS = [
+    ("1d_advection", "main", "1d_advection.cfg", [],
+     [("results.dat", "1d_advection_parallel/results.dat", 0),
+      ("fluxes.dat", "1d_advection_parallel/fluxes.dat", 0)], False),
+    ("1d_advection_double", "main_double", "1d_advection.cfg", [],
+     [("results.dat", "1DAdvectionDocker/results.dat", 0),
+      ("fluxes.dat", "1DAdvectionDocker/fluxes.dat", 0)], False),
+    ("1d_diffusion", "main", "1d_diffusion.cfg", [],
+     [("results.dat", "diffusion_parallel/results.dat", 0),
+      ("fluxes.dat", "diffusion_parallel/fluxes.dat", 0)], False),
+    # diffusion/1D_diffusion.c: the same case in double, advected faster
+    ("1d_diffusion_double", "main_double", "1d_diffusion.cfg",
+     ["u=0.5", "alpha=0.000024", "cfl=0.001", "t_final=0.1"],
+     [("results.dat", "diffusion/results.dat", 0),
+      ("fluxes.dat", "diffusion/fluxes.dat", 0)], False),
+    # slab=1 must be bitwise the barrier loop, for any np
+    ("1d_advection_slab", "main", "1d_advection.cfg", ["slab=1", "np=3"],
+     [("results.dat", "1d_advection_parallel/results.dat", 0),
+      ("fluxes.dat", "1d_advection_parallel/fluxes.dat", 0)], False),
+    ("1d_advection_double_slab", "main_double", "1d_advection.cfg", ["slab=1", "np=4"],
+     [("results.dat", "1DAdvectionDocker/results.dat", 0),
+      ("fluxes.dat", "1DAdvectionDocker/fluxes.dat", 0)], False),
+    ("1d_diffusion_slab", "main", "1d_diffusion.cfg", ["slab=1", "np=3"],
+     [("results.dat", "diffusion_parallel/results.dat", 0),
+      ("fluxes.dat", "diffusion_parallel/fluxes.dat", 0)], False),
+    ("2d_diffusion", "main", "2d_diffusion.cfg", [],
+     # float rounding: the old code had float coefficients, the kernels
+     # use double ones
+     [("resultsT.txt", "2d_diffusion_parallel/resultsT.txt", 2e-6),
+      ("results.txt", "2d_diffusion_parallel/results.txt", 0)], False),
+    # steal=1 hands tiles out by timing; the field and the error must not care
+    ("2d_diffusion_steal", "main", "2d_diffusion.cfg", ["steal=1", "tile_x=8", "np=4"],
+     [("resultsT.txt", "2d_diffusion_parallel/resultsT.txt", 2e-6),
+      ("results.txt", "2d_diffusion_parallel/results.txt", 0)], False),
+    ("2d_diffusion_steal_active", "main", "2d_diffusion.cfg",
+     ["steal=1", "active_tile=16", "tile_x=8", "np=3"],
+     [("resultsT.txt", "2d_diffusion_parallel/resultsT.txt", 2e-6),
+      ("results.txt", "2d_diffusion_parallel/results.txt", 0)], False),
+    # a sweep list longer than 256 characters must reach every member;
+    # the golden table is 1D ensemble output, bitwise each member's single run
+    ("1d_advection_sweep64", "main", "1d_advection.cfg", ["sweep_u=" + SWEEP_64],
+     [("ensemble.txt", "solver/golden/1d_advection_sweep64/ensemble.txt", 0)], False),
+    # 2d_a_d.cfg keeps the old rusanov_speed = 0.5 in both directions, so
+    # the field is the old one bitwise; the old code summed the squared
+    # errors serially in float, main sums them in double (3e-5 relative)
+    ("2d_a_d", "main", "2d_a_d.cfg", [],
+     [("results.txt", "2d_a_d/results.txt", 2e-7)], True),
+]
+
+
+def compare(out, golden, rtol, atol):
+    """the worst |out - golden| / (atol + rtol*|golden|), inf on a shape
+    mismatch"""
+    a = np.atleast_2d(np.loadtxt(out, comments=("#", "member")))
+    g = np.atleast_2d(np.loadtxt(golden, comments=("#", "member")))
+    if a.shape != g.shape:
+        return float("inf")
+    return float(np.max(np.abs(a - g) / (atol + rtol * np.abs(g))))
+
+
+def run(scenario, opt):
+    """(status, detail, wall s, cell updates/s)"""
+    name, binary, config, args, goldens, _ = scenario
+    exe = os.path.join(HERE, binary)
+    if not os.path.exists(exe):
+        return "skip", "no %s (make first)" % binary, 0.0, 0.0
+    # the scenario's own args come last, so they may pin np
+    cmd = [exe, os.path.join(HERE, "configs", config), "output=text", "debug=0",
+           "np=%d" % opt.np] + args
+    with tempfile.TemporaryDirectory() as wd:
+        best, rate, out, spent, runs = None, 0.0, None, 0.0, 0
+        while runs < opt.repeat or (spent < opt.min_time and runs < 100):
+            runs += 1
+            t0 = time.time()
+            out = subprocess.run(cmd, cwd=wd, capture_output=True, text=True)
+            wall = time.time() - t0
+            spent += wall
+            if out.returncode != 0:
+                return "fail", out.stderr.strip(), wall, 0.0
+            m = re.search(r"([0-9.e+-]+) (?:member )?cell updates/s", out.stdout)
+            if m and float(m.group(1)) > rate:
+                rate = float(m.group(1))
+            best = wall if best is None else min(best, wall)
+        worst = max([compare(os.path.join(wd, o), os.path.join(REPO, g), opt.rtol, max(atol, opt.atol))
+                     for o, g, atol in goldens] + [0.0])
+    if worst > 1.0:
+        return "fail", "off by %.3g x the tolerance" % worst, best, rate
+    return "pass", "within %.3g of the tolerance" % worst, best, rate
+
+
+def commit():
+    try:
+        return subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=HERE,
+                              capture_output=True, text=True).stdout.strip()
+    except OSError:
+        return ""
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("names", nargs="*", help="scenarios to run (default: all quick ones)")
+    ap.add_argument("--all", action="store_true", help="include the slow scenarios")
+    ap.add_argument("--np", type=int, default=1, help="threads per run")
+    ap.add_argument("--repeat", type=int, default=3, help="runs per scenario, the fastest counts")
+    ap.add_argument("--min_time", type=float, default=1.0,
+                    help="repeat short scenarios until their runs take this long")
+    ap.add_argument("--rtol", type=float, default=2e-5)
+    ap.add_argument("--atol", type=float, default=1e-12)
+    ap.add_argument("--threshold", type=float, default=0.10,
+                    help="updates/s drop that counts as a regression")
+    ap.add_argument("--window", type=int, default=5, help="past runs the median is taken over")
+    ap.add_argument("--history", default=os.path.join(HERE, "regress_history.json"))
+    opt = ap.parse_args()
+
+    known = [s[0] for s in SCENARIOS]
+    for n in opt.names:
+        if n not in known:
+            ap.error("unknown scenario %s (%s)" % (n, ", ".join(known)))
+    if opt.names:
+        chosen = [s for s in SCENARIOS if s[0] in opt.names]
+    else:
+        chosen = [s for s in SCENARIOS if opt.all or not s[5]]
+
+    history = []
+    if os.path.exists(opt.history):
+        with open(opt.history) as fp:
+            history = json.load(fp)
+    host = platform.node()
+
+    record = {"date": datetime.datetime.now().isoformat(timespec="seconds"),
+              "commit": commit(), "host": host, "np": opt.np, "scenarios": {}}
+    bad = 0
+    print("%-26s %-6s %10s %14s  %s" % ("scenario", "status", "wall s", "updates/s", "detail"))
+    for s in chosen:
+        status, detail, wall, rate = run(s, opt)
+        past = [h["scenarios"][s[0]]["updates_per_s"] for h in history
+                if h.get("host") == host and h.get("np") == opt.np
+                and h["scenarios"].get(s[0], {}).get("status") == "pass"
+                and h["scenarios"][s[0]]["updates_per_s"] > 0][-opt.window:]
+        if status == "pass" and past and rate > 0:
+            ref = statistics.median(past)
+            change = rate / ref - 1.0
+            detail += ", %+.1f%% updates/s against the median of %d" % (100 * change, len(past))
+            if change < -opt.threshold:
+                status = "slow"
+        if status in ("fail", "slow"):
+            bad += 1
+        print("%-26s %-6s %10.4g %14.4g  %s" % (s[0], status, wall, rate, detail))
+        if status != "skip":
+            record["scenarios"][s[0]] = {"status": status, "wall_s": wall, "updates_per_s": rate}
+
+    history.append(record)
+    with open(opt.history, "w") as fp:
+        json.dump(history, fp, indent=1)
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,20 @@
+#include "riemann.h"
+
+#define RIEMANN_BATCH_DEF(FLUX, NAME)                                    \
+void Riemann_Batch_##NAME(real a, const struct Riemann_Batch *b)         \
+{                                                                        \
+	Riemann_Batch_Body(FLUX, a, b);                                  \
+}
+RIEMANN_SCHEMES(RIEMANN_BATCH_DEF)
+
+#define RIEMANN_BATCH_ENTRY(FLUX, NAME) [FLUX] = Riemann_Batch_##NAME,
+static const Riemann_Batch_Fn batch_fns[NUM_FLUX_SCHEMES] = {
+	RIEMANN_SCHEMES(RIEMANN_BATCH_ENTRY)
+};
+
+Riemann_Batch_Fn Riemann_Get_Batch(int flux)
+{
+	if (flux < 0 || flux >= NUM_FLUX_SCHEMES)
+		return 0;
+	return batch_fns[flux];
+}
@@ -0,0 +1,155 @@
+#ifndef RIEMANN_H
+#define RIEMANN_H
+
+#include "solver.h"
+
+/*
+   Riemann solvers for the scalar conservation law u_t + f(u)_x = 0 with
+   the linear flux f(u) = a*u of all the solvers here.
+
+   Each scheme is a static inline per-interface function; Riemann_Flux()
+   picks one through a switch on a scheme that is a compile-time constant
+   at every call site (the kernels are instantiated once per scheme with
+   RIEMANN_SCHEMES), so the per-interface loops have no indirect calls.
+
+   HLL and Roe are written in their general form.  For the linear flux
+   every wave travels at a, so HLL (sL = sR = a) reduces to upwind and
+   Roe (a_roe = a) to the Rusanov formula with |a|; they start to differ
+   once f is nonlinear or a varies in space.
+
+   The double constants keep the blend in double precision as the old
+   solvers did; in float it underflows to slow denormals far from the
+   pulse.
+*/
+
+/* X(enum, name) for every scheme, in enum Flux_Scheme order */
+#define RIEMANN_SCHEMES(X)              \
+	X(FLUX_UPWIND,  upwind)         \
+	X(FLUX_CENTRAL, central)        \
+	X(FLUX_RUSANOV, rusanov)        \
+	X(FLUX_HLL,     hll)            \
+	X(FLUX_ROE,     roe)
+
+#define NUM_FLUX_SCHEMES 5
+
+static inline real Riemann_Upwind(real a, real l, real r)
+{
+	return (a > 0) ? a*l : a*r;
+}
+
+static inline real Riemann_Central(real a, real l, real r)
+{
+	real left_F = a*l;
+	real right_F = a*r;
+	return 0.5 * (left_F + right_F);
+}
+
+/* Rusanov flux with the dissipation speed smax given */
+static inline real Riemann_Rusanov_Speed(real a, real smax, real l, real r)
+{
+	real left_F = a*l;
+	real right_F = a*r;
+	return 0.5 * (left_F + right_F) - 0.5*smax*(r - l);
+}
+
+/* local Lax-Friedrichs: dissipation from the fastest local wave */
+static inline real Riemann_Rusanov(real a, real l, real r)
+{
+	real smax = (a < 0) ? -a : a;    /* max(|f'(l)|, |f'(r)|) */
+	return Riemann_Rusanov_Speed(a, smax, l, r);
+}
+
+/* HLL with Davis wave speed estimates sL = min(f'(l), f'(r)), sR = max */
+static inline real Riemann_HLL(real a, real l, real r)
+{
+	real left_F = a*l;
+	real right_F = a*r;
+	real sl = a;
+	real sr = a;
+
+	if (sl >= 0)
+		return left_F;
+	if (sr <= 0)
+		return right_F;
+	return (sr*left_F - sl*right_F + sl*sr*(r - l)) / (sr - sl);
+}
+
+/* Roe: upwinding on the Roe average speed (f(r)-f(l))/(r-l), which is
+   exactly a for the linear flux, so no division is needed */
+static inline real Riemann_Roe(real a, real l, real r)
+{
+	real left_F = a*l;
+	real right_F = a*r;
+	real a_roe = a;
+	real abs_a = (a_roe < 0) ? -a_roe : a_roe;
+	return 0.5 * (left_F + right_F) - 0.5*abs_a*(r - l);
+}
+
+static inline real Riemann_Flux(int flux, real a, real l, real r)
+{
+	switch (flux) {
+	case FLUX_UPWIND:
+		return Riemann_Upwind(a, l, r);
+	case FLUX_CENTRAL:
+		return Riemann_Central(a, l, r);
+	case FLUX_HLL:
+		return Riemann_HLL(a, l, r);
+	case FLUX_ROE:
+		return Riemann_Roe(a, l, r);
+	case FLUX_RUSANOV:
+	default:
+		return Riemann_Rusanov(a, l, r);
+	}
+}
+
+/* Riemann_Flux, but Rusanov dissipates at the speed s instead of |a|
+   (rusanov_speed; the old 2d_a_d solver damped both directions with
+   0.5*|u|) */
+static inline real Riemann_Flux_Speed(int flux, real a, real s, real l, real r)
+{
+	if (flux == FLUX_RUSANOV)
+		return Riemann_Rusanov_Speed(a, s, l, r);
+	return Riemann_Flux(flux, a, l, r);
+}
+
+/* |f'(u)|, the local wave speed the time step has to resolve */
+static inline real Riemann_Wave_Speed(real a, real u)
+{
+	(void)u;    /* f'(u) = a for the linear flux */
+	return (a < 0) ? -a : a;
+}
+
+/* A batch of n interfaces in SoA form: left states, right states and
+   fluxes each in their own array.  For a 1D grid uL = u + j0 - 1,
+   uR = u + j0 and F = F + j0 cover the interfaces [j0, j0+n). */
+struct Riemann_Batch {
+	int n;
+	const real *uL;
+	const real *uR;
+	real *F;
+};
+
+static inline __attribute__((always_inline))
+void Riemann_Batch_Body(int flux, real a, const struct Riemann_Batch *b)
+{
+	int n = b->n;
+	const real *uL = b->uL;
+	const real *uR = b->uR;
+	real *F = b->F;
+
+	for (int i = 0; i < n; i++)
+		F[i] = Riemann_Flux(flux, a, uL[i], uR[i]);
+}
+
+/* one out-of-line batch solver per scheme: Riemann_Batch_upwind() ... */
+typedef void (*Riemann_Batch_Fn)(real a, const struct Riemann_Batch *b);
+
+#define RIEMANN_BATCH_DECL(FLUX, NAME) \
+	void Riemann_Batch_##NAME(real a, const struct Riemann_Batch *b);
+RIEMANN_SCHEMES(RIEMANN_BATCH_DECL)
+#undef RIEMANN_BATCH_DECL
+
+/* for callers that choose at run time: one indirect call per batch */
+Riemann_Batch_Fn Riemann_Get_Batch(int flux);
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "params.h"
+#include "riemann.h"
+
+/*
+   Throughput of the batched Riemann solvers: every scheme solves the same
+   random batch of interfaces (in cache) over and over.
+
+       ./riemann_bench [batch size] [repeats]
+*/
+
+int main(int argc, char **argv)
+{
+	int n = (argc > 1) ? atoi(argv[1]) : 4096;
+	int reps = (argc > 2) ? atoi(argv[2]) : 20000;
+	real a = 0.5;
+
+	if (n < 1 || reps < 1) {
+		fprintf(stderr, "usage: %s [batch size] [repeats]\n", argv[0]);
+		return 1;
+	}
+
+	/* n+1 states give n interfaces: uL = u, uR = u + 1 */
+	real *u = (real*)malloc((n+1)*sizeof(real));
+	real *F = (real*)malloc(n*sizeof(real));
+	if (!u || !F) {
+		fprintf(stderr, "allocation failed\n");
+		return 1;
+	}
+	srand(1);
+	for (int i = 0; i <= n; i++)
+		u[i] = (real)rand() / RAND_MAX;
+
+	struct Riemann_Batch b = { n, u, u + 1, F };
+
+	printf("%d interfaces x %d batches, a = %g\n", n, reps, (double)a);
+	printf("%-10s %12s %14s %12s\n", "scheme", "ns/iface", "Miface/s", "checksum");
+	for (int flux = 0; flux < NUM_FLUX_SCHEMES; flux++) {
+		Riemann_Batch_Fn solve = Riemann_Get_Batch(flux);
+
+		solve(a, &b);    /* warm up */
+		double t0 = omp_get_wtime();
+		for (int r = 0; r < reps; r++) {
+			solve(a, &b);
+			/* keep the compiler from hoisting the batch out of the loop */
+			__asm__ __volatile__("" : : "r"(F) : "memory");
+		}
+		double t = omp_get_wtime() - t0;
+
+		double sum = 0.0;
+		for (int i = 0; i < n; i++)
+			sum += F[i];
+		double total = (double)n*reps;
+		printf("%-10s %12.3f %14.1f %12.6g\n", Flux_Name(flux),
+		       1e9*t/total, total/t/1e6, sum);
+	}
+
+	free(u);
+	free(F);
+	return 0;
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <math.h>
+#include <omp.h>
+#include "sched.h"
+#include "field_alloc.h"
+
+#define PACK(lo, hi) ((unsigned long long)(unsigned)(lo) << 32 | (unsigned)(hi))
+
+static inline int Lo(unsigned long long r) { return (int)(r >> 32); }
+static inline int Hi(unsigned long long r) { return (int)(r & 0xffffffffu); }
+
+struct Tile_Sched *Sched_Create(const struct Params *p)
+{
+	struct Tile_Sched *s = Work_Alloc(sizeof(*s));
+
+	s->nthreads = p->np;
+	s->dq = Work_Alloc_Aligned(p->np*sizeof(*s->dq));
+	for (int t = 0; t < p->np; t++) {
+		atomic_init(&s->dq[t].range, PACK(0, 0));
+		s->dq[t].taken = s->dq[t].stolen = 0;
+	}
+	s->nx = p->nx;
+	s->ny = p->ny;
+	s->tile_x = p->tile_x < p->nx ? p->tile_x : p->nx;
+	s->tile_y = p->tile_y < p->ny ? p->tile_y : p->ny;
+	s->tiles_x = (p->nx + s->tile_x - 1) / s->tile_x;
+	s->tiles_y = (p->ny + s->tile_y - 1) / s->tile_y;
+	s->ntiles = s->tiles_x*s->tiles_y;
+	s->partial = Work_Alloc(3*(size_t)s->ntiles*sizeof(double));
+	return s;
+}
+
+void Sched_Free(struct Tile_Sched *s)
+{
+	if (!s)
+		return;
+	free(s->dq);
+	free(s->partial);
+	free(s);
+}
+
+void Sched_Start(struct Tile_Sched *s, int count)
+{
+	int t = omp_get_thread_num();
+	int n = omp_get_num_threads();
+
+	if (n > s->nthreads) {
+		fprintf(stderr, "tile scheduler set up for %d threads, called by %d\n", s->nthreads, n);
+		exit(1);
+	}
+	atomic_store_explicit(&s->dq[t].range,
+			      PACK((long)count*t/n, (long)count*(t+1)/n), memory_order_release);
+}
+
+/* the front item of the owner's deque, or -1 */
+static int Take(struct Sched_Deque *d)
+{
+	unsigned long long r = atomic_load_explicit(&d->range, memory_order_acquire);
+
+	while (Lo(r) < Hi(r)) {
+		if (atomic_compare_exchange_weak_explicit(&d->range, &r, PACK(Lo(r) + 1, Hi(r)),
+							  memory_order_acq_rel, memory_order_acquire))
+			return Lo(r);
+	}
+	return -1;
+}
+
+/* the back half of the victim's deque into [*lo, *hi); 0 if it is empty */
+static int Steal(struct Sched_Deque *victim, int *lo, int *hi)
+{
+	unsigned long long r = atomic_load_explicit(&victim->range, memory_order_acquire);
+
+	while (Lo(r) < Hi(r)) {
+		int mid = Lo(r) + (Hi(r) - Lo(r))/2;
+		if (atomic_compare_exchange_weak_explicit(&victim->range, &r, PACK(Lo(r), mid),
+							  memory_order_acq_rel, memory_order_acquire)) {
+			*lo = mid;
+			*hi = Hi(r);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int Sched_Next(struct Tile_Sched *s)
+{
+	int t = omp_get_thread_num();
+	int n = omp_get_num_threads();
+	struct Sched_Deque *d = &s->dq[t];
+	int i = Take(d);
+
+	if (i >= 0) {
+		d->taken++;
+		return i;
+	}
+
+	/* nearest neighbours first: their items are the adjacent tiles */
+	for (int dist = 1; dist < n; dist++) {
+		for (int side = 0; side < 2; side++) {
+			int v = side ? t - dist : t + dist;
+			int lo, hi;
+			if (v < 0 || v >= n || !Steal(&s->dq[v], &lo, &hi))
+				continue;
+			/* our deque is empty, so no thief touches it until this store */
+			atomic_store_explicit(&d->range, PACK(lo + 1, hi), memory_order_release);
+			d->stolen += hi - lo;
+			d->taken++;
+			return lo;
+		}
+	}
+	return -1;
+}
+
+void Sched_Errors_2D(struct Tile_Sched *s, const real *T, const real *A,
+		     double *sum2, double *sum1, double *max)
+{
+	int ny = s->ny;
+
+	Sched_Start(s, s->ntiles);
+	for (int t; (t = Sched_Next(s)) >= 0; ) {
+		int j0, j1, k0, k1;
+		double e2 = 0.0, e1 = 0.0, em = 0.0;
+
+		Sched_Tile(s, t, &j0, &j1, &k0, &k1);
+		for (int j = j0; j < j1; j++) {
+			for (int k = k0; k < k1; k++) {
+				long i = (long)j*ny + k;
+				e2 += (T[i] - A[i])*(T[i] - A[i]);
+				e1 += fabs(T[i] - A[i]);
+				em = fmax(em, fabs(T[i] - A[i]));
+			}
+		}
+		s->partial[3*t] = e2;
+		s->partial[3*t+1] = e1;
+		s->partial[3*t+2] = em;
+	}
+
+	/* tile order, whoever computed them */
+	#pragma omp barrier
+	#pragma omp single
+	{
+		double e2 = 0.0, e1 = 0.0, em = 0.0;
+		for (int t = 0; t < s->ntiles; t++) {
+			e2 += s->partial[3*t];
+			e1 += s->partial[3*t+1];
+			em = fmax(em, s->partial[3*t+2]);
+		}
+		*sum2 = e2;
+		*sum1 = e1;
+		*max = em;
+	}
+}
+
+void Sched_Print(const struct Tile_Sched *s, FILE *fp)
+{
+	long taken = 0, stolen = 0, least = -1, most = 0;
+
+	for (int t = 0; t < s->nthreads; t++) {
+		const struct Sched_Deque *d = &s->dq[t];
+		taken += d->taken;
+		stolen += d->stolen;
+		if (least < 0 || d->taken < least)
+			least = d->taken;
+		if (d->taken > most)
+			most = d->taken;
+	}
+	fprintf(fp, "steal: %d tiles of %dx%d, %ld items run, %.1f%% stolen, %ld to %ld per thread\n",
+		s->ntiles, s->tile_x, s->tile_y, taken, taken ? 100.0*stolen/taken : 0.0, least, most);
+}
@@ -0,0 +1,74 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "solver.h"
+
+/*
+   Work-stealing tile scheduler for the 2D loops (steal=1).
+
+   The grid is cut into tile_x x tile_y tiles, numbered row-major.  At
+   the start of every phase each thread gets the contiguous run of items
+   it would get from a static schedule, as a range [lo, hi) packed into
+   one atomic word: its deque.  The owner takes items from the front, in
+   grid order, so its tiles stay the ones it touched in the last phase.
+   A thread whose deque is empty steals the back half of the nearest
+   non-empty deque (t+1, t-1, t+2, ...), so what it steals is still a
+   contiguous band of the grid next to its own, and continues on that.
+   Taking and stealing are one compare-and-swap each.
+
+   A phase is: Sched_Start, Sched_Next until it returns -1, and a
+   barrier.  Sched_Start only resets the caller's own deque; a thread
+   that starts stealing before a slower one has reset its deque finds it
+   empty, which costs balance, never correctness.
+
+   The same scheduler drives the fused flux/update step, the active-tile
+   step (over the active list) and the error reduction.  The reduction
+   keeps one partial sum per tile and adds them up in tile order, so its
+   result does not depend on who stole what.
+*/
+
+struct Sched_Deque {
+	_Alignas(64) atomic_ullong range;       /* lo << 32 | hi */
+	long taken, stolen;     /* owner only */
+};
+
+struct Tile_Sched {
+	int nthreads;
+	struct Sched_Deque *dq;
+	int nx, ny;
+	int tile_x, tile_y;
+	int tiles_x, tiles_y, ntiles;
+	double *partial;        /* 3 error sums per tile */
+};
+
+/* tile_x x tile_y tiles of the nx x ny grid for p->np threads; exits
+   on failure */
+struct Tile_Sched *Sched_Create(const struct Params *p);
+void Sched_Free(struct Tile_Sched *s);
+
+/* every thread, at the start of a phase over the items [0, count) */
+void Sched_Start(struct Tile_Sched *s, int count);
+
+/* the calling thread's next item, -1 when there is nothing left anywhere */
+int Sched_Next(struct Tile_Sched *s);
+
+/* the cells [j0,j1) x [k0,k1) of tile t */
+static inline void Sched_Tile(const struct Tile_Sched *s, int t, int *j0, int *j1, int *k0, int *k1)
+{
+	*j0 = (t / s->tiles_y)*s->tile_x;
+	*k0 = (t % s->tiles_y)*s->tile_y;
+	*j1 = *j0 + s->tile_x < s->nx ? *j0 + s->tile_x : s->nx;
+	*k1 = *k0 + s->tile_y < s->ny ? *k0 + s->tile_y : s->ny;
+}
+
+/* every thread: sum (T-A)^2, sum |T-A| and max |T-A| over the grid,
+   the same for every schedule; ends with a barrier */
+void Sched_Errors_2D(struct Tile_Sched *s, const real *T, const real *A,
+		     double *sum2, double *sum1, double *max);
+
+/* items taken and stolen per thread */
+void Sched_Print(const struct Tile_Sched *s, FILE *fp);
+
+#endif
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+#endif
+
+int Simd_Supported(int backend)
+{
+	switch (backend) {
+	case SIMD_SCALAR:
+		return 1;
+#if defined(__x86_64__) || defined(__i386__)
+	case SIMD_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case SIMD_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+#if defined(__aarch64__)
+	case SIMD_SVE:
+		return (getauxval(AT_HWCAP) & HWCAP_SVE) != 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+int Simd_Resolve(int backend)
+{
+	if (backend == SIMD_OFF)
+		return SIMD_OFF;
+	if (backend == SIMD_AUTO) {
+		static const int order[] = { SIMD_SVE, SIMD_AVX512, SIMD_AVX2, SIMD_SCALAR };
+		for (int i = 0; i < (int)(sizeof(order)/sizeof(order[0])); i++) {
+			if (Simd_Supported(order[i]))
+				return order[i];
+		}
+	}
+	if (!Simd_Supported(backend)) {
+		fprintf(stderr, "simd backend %s is not supported on this CPU\n", Simd_Name(backend));
+		return -1;
+	}
+	return backend;
+}
+
+const struct Simd_Ops *Simd_Get(int backend)
+{
+	switch (backend) {
+	case SIMD_SCALAR:
+		return &simd_scalar_ops;
+#if defined(__x86_64__) || defined(__i386__)
+	case SIMD_AVX2:
+		return &simd_avx2_ops;
+	case SIMD_AVX512:
+		return &simd_avx512_ops;
+#endif
+#if defined(__aarch64__)
+	case SIMD_SVE:
+		return &simd_sve_ops;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+unsigned long Simd_Flush_Denormals_Save(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned long mode = _mm_getcsr();
+	/* FTZ | DAZ */
+	_mm_setcsr(mode | 0x8040);
+	return mode;
+#elif defined(__aarch64__)
+	unsigned long fpcr;
+	__asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+	/* FZ */
+	__asm__ volatile("msr fpcr, %0" : : "r"(fpcr | 1ul << 24));
+	return fpcr;
+#else
+	return 0;
+#endif
+}
+
+void Simd_Restore_Denormals(unsigned long mode)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_setcsr((unsigned int)mode);
+#elif defined(__aarch64__)
+	__asm__ volatile("msr fpcr, %0" : : "r"(mode));
+#else
+	(void)mode;
+#endif
+}
+
+void Simd_Flush_Denormals(void)
+{
+	(void)Simd_Flush_Denormals_Save();
+}
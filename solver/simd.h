@@ -0,0 +1,57 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "solver.h"
+
+/*
+   Explicit SIMD kernels for the upwind / central / Rusanov fluxes.
+
+   simd_kernels.h holds one vector-length-agnostic source written against
+   a small predicated vocabulary (whilelt, masked load/store, select); each
+   simd_<backend>.c defines that vocabulary for one instruction set and
+   includes it.  Loops have no scalar tail and the wall cells are handled
+   with lane predicates instead of branches.
+
+   All backends work in the precision of `real` with the same operation
+   order, so every vector backend is bitwise identical to the scalar one
+   (simd_check verifies it).  They do not match the default kernels in
+   kernel1d.c / kernel2d.c, which blend in double like the old solvers.
+*/
+
+struct Simd_Ops {
+	const char *name;
+
+	/* F[j] for j in [j0, j1), interface j between cells j-1 and j */
+	void (*fluxes_1d)(int flux, real a, real alpha_dx, const real *u, real *F, int j0, int j1);
+
+	/* one row of the fused 2D step, same contract as Step_2D_Row */
+	void (*row_2d)(const struct Coeffs_2D *c, int flux,
+		       const real *Tc, const real *Tw, const real *Te, real *Tn,
+		       int west_wall, int east_wall, int bottom_wall, int top_wall, int cnt);
+};
+
+extern const struct Simd_Ops simd_scalar_ops;
+#if defined(__x86_64__) || defined(__i386__)
+extern const struct Simd_Ops simd_avx2_ops;
+extern const struct Simd_Ops simd_avx512_ops;
+#endif
+#if defined(__aarch64__)
+extern const struct Simd_Ops simd_sve_ops;
+#endif
+
+int Simd_Supported(int backend);
+/* SIMD_AUTO -> best backend this CPU runs; -1 if unsupported */
+int Simd_Resolve(int backend);
+const struct Simd_Ops *Simd_Get(int backend);
+
+/* flush denormals to zero on the calling thread (they are very slow in
+   the float vector units and only appear far out in the pulse tails) */
+void Simd_Flush_Denormals(void);
+
+/* the same for one solve: returns the thread's previous mode, which
+   Simd_Restore_Denormals puts back, so the flush does not leak into the
+   kernels that run after it */
+unsigned long Simd_Flush_Denormals_Save(void);
+void Simd_Restore_Denormals(unsigned long mode);
+
+#endif
@@ -0,0 +1,54 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("avx2")
+
+#include <immintrin.h>
+#include "simd.h"
+
+#ifdef USE_DOUBLE
+
+#define VEC                 __m256d
+#define PRED                __m256i
+#define V_LANES()           4
+#define V_IOTA              _mm256_set_epi64x(3, 2, 1, 0)
+#define V_WHILELT(i, n)     _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)(n) - (i)), V_IOTA)
+#define V_LANE(l)           _mm256_cmpeq_epi64(_mm256_set1_epi64x(l), V_IOTA)
+#define V_LOAD(pg, p)       _mm256_maskload_pd((p), (pg))
+#define V_STORE(pg, p, v)   _mm256_maskstore_pd((p), (pg), (v))
+#define V_DUP(x)            _mm256_set1_pd(x)
+#define V_ADD(a, b)         _mm256_add_pd((a), (b))
+#define V_SUB(a, b)         _mm256_sub_pd((a), (b))
+#define V_MUL(a, b)         _mm256_mul_pd((a), (b))
+#define V_SEL(pg, a, b)     _mm256_blendv_pd((b), (a), _mm256_castsi256_pd(pg))
+
+#else
+
+#define VEC                 __m256
+#define PRED                __m256i
+#define V_LANES()           8
+#define V_IOTA              _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)
+#define V_WHILELT(i, n)     _mm256_cmpgt_epi32(_mm256_set1_epi32((n) - (i)), V_IOTA)
+#define V_LANE(l)           _mm256_cmpeq_epi32(_mm256_set1_epi32(l), V_IOTA)
+#define V_LOAD(pg, p)       _mm256_maskload_ps((p), (pg))
+#define V_STORE(pg, p, v)   _mm256_maskstore_ps((p), (pg), (v))
+#define V_DUP(x)            _mm256_set1_ps(x)
+#define V_ADD(a, b)         _mm256_add_ps((a), (b))
+#define V_SUB(a, b)         _mm256_sub_ps((a), (b))
+#define V_MUL(a, b)         _mm256_mul_ps((a), (b))
+#define V_SEL(pg, a, b)     _mm256_blendv_ps((b), (a), _mm256_castsi256_ps(pg))
+
+#endif
+
+#define P_NONE              _mm256_setzero_si256()
+#define P_ANDNOT(a, b)      _mm256_andnot_si256((b), (a))
+#define SIMD_NAME(x)        x##_avx2
+
+#include "simd_kernels.h"
+
+const struct Simd_Ops simd_avx2_ops = {
+	"avx2",
+	Fluxes_1D_avx2,
+	Row_2D_avx2,
+};
+
+#endif
@@ -0,0 +1,65 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("avx512f")
+
+#include <immintrin.h>
+#include "simd.h"
+
+#ifdef USE_DOUBLE
+
+#define VEC                 __m512d
+#define PRED                __mmask8
+#define V_LANES()           8
+#define V_LOAD(pg, p)       _mm512_maskz_loadu_pd((pg), (p))
+#define V_STORE(pg, p, v)   _mm512_mask_storeu_pd((p), (pg), (v))
+#define V_DUP(x)            _mm512_set1_pd(x)
+#define V_ADD(a, b)         _mm512_add_pd((a), (b))
+#define V_SUB(a, b)         _mm512_sub_pd((a), (b))
+#define V_MUL(a, b)         _mm512_mul_pd((a), (b))
+#define V_SEL(pg, a, b)     _mm512_mask_blend_pd((pg), (b), (a))
+
+#else
+
+#define VEC                 __m512
+#define PRED                __mmask16
+#define V_LANES()           16
+#define V_LOAD(pg, p)       _mm512_maskz_loadu_ps((pg), (p))
+#define V_STORE(pg, p, v)   _mm512_mask_storeu_ps((p), (pg), (v))
+#define V_DUP(x)            _mm512_set1_ps(x)
+#define V_ADD(a, b)         _mm512_add_ps((a), (b))
+#define V_SUB(a, b)         _mm512_sub_ps((a), (b))
+#define V_MUL(a, b)         _mm512_mul_ps((a), (b))
+#define V_SEL(pg, a, b)     _mm512_mask_blend_ps((pg), (b), (a))
+
+#endif
+
+static inline PRED Whilelt(int i, int n)
+{
+	int left = n - i;
+	if (left <= 0)
+		return 0;
+	if (left >= V_LANES())
+		return (PRED)~0;
+	return (PRED)((1u << left) - 1);
+}
+
+static inline PRED Lane(int l)
+{
+	return (l >= 0 && l < V_LANES()) ? (PRED)(1u << l) : 0;
+}
+
+#define V_WHILELT(i, n)     Whilelt((i), (n))
+#define V_LANE(l)           Lane(l)
+#define P_NONE              ((PRED)0)
+#define P_ANDNOT(a, b)      ((PRED)((a) & ~(b)))
+#define SIMD_NAME(x)        x##_avx512
+
+#include "simd_kernels.h"
+
+const struct Simd_Ops simd_avx512_ops = {
+	"avx512",
+	Fluxes_1D_avx512,
+	Row_2D_avx512,
+};
+
+#endif
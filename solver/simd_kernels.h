@@ -0,0 +1,149 @@
+/*
+   Vector-length-agnostic flux kernels.  Not a normal header: it is
+   included once by each simd_<backend>.c after that file has defined
+
+       VEC, PRED              vector of real, lane predicate
+       V_LANES()              lanes per vector (may be a run-time value)
+       V_WHILELT(i, n)        lanes l with i+l < n
+       V_LANE(l)              only lane l (none if l is out of range)
+       P_NONE, P_ANDNOT(a, b) empty predicate, a & ~b
+       V_LOAD(pg, p)          masked load, inactive lanes 0, never faults
+       V_STORE(pg, p, v)      masked store
+       V_DUP(x), V_ADD, V_SUB, V_MUL
+       V_SEL(pg, a, b)        pg ? a : b per lane
+       SIMD_NAME(x)           x with the backend suffix
+
+   No fused multiply-adds: every backend must round exactly like the
+   scalar one, which is why the makefile builds with -ffp-contract=off
+   (GCC would otherwise fuse the AVX-512 mul/add intrinsics).
+*/
+
+static inline __attribute__((always_inline))
+VEC Flux_V(int flux, int a_pos, int a_nonneg, VEC va, VEC vhalf, VEC vhs, VEC l, VEC r)
+{
+	VEC left_F = V_MUL(va, l);
+	VEC right_F = V_MUL(va, r);
+
+	/* see riemann.h: with one wave speed a, HLL picks a side by its
+	   sign and Roe is the Rusanov formula with |a| */
+	switch (flux) {
+	case FLUX_UPWIND:
+		return a_pos ? left_F : right_F;
+	case FLUX_HLL:
+		return a_nonneg ? left_F : right_F;
+	case FLUX_CENTRAL:
+		return V_MUL(vhalf, V_ADD(left_F, right_F));
+	case FLUX_RUSANOV:
+	case FLUX_ROE:
+	default:
+		return V_SUB(V_MUL(vhalf, V_ADD(left_F, right_F)), V_MUL(vhs, V_SUB(r, l)));
+	}
+}
+
+static inline __attribute__((always_inline))
+void Fluxes_1D_V(int flux, real a, real alpha_dx, const real *u, real *F, int j0, int j1)
+{
+	VEC va = V_DUP(a);
+	VEC vhalf = V_DUP((real)0.5);
+	VEC vhs = V_DUP((real)0.5*(a < 0 ? -a : a));
+	VEC vad = V_DUP(alpha_dx);
+	int a_pos = a > 0;
+
+	for (int j = j0; j < j1; j += V_LANES()) {
+		PRED pg = V_WHILELT(j, j1);
+		VEC l = V_LOAD(pg, u + j - 1);
+		VEC r = V_LOAD(pg, u + j);
+		VEC f = Flux_V(flux, a_pos, a >= 0, va, vhalf, vhs, l, r);
+		V_STORE(pg, F + j, V_SUB(f, V_MUL(vad, V_SUB(r, l))));
+	}
+}
+
+static void SIMD_NAME(Fluxes_1D)(int flux, real a, real alpha_dx, const real *u, real *F, int j0, int j1)
+{
+	switch (flux) {
+	case FLUX_UPWIND:
+		Fluxes_1D_V(FLUX_UPWIND, a, alpha_dx, u, F, j0, j1);
+		break;
+	case FLUX_CENTRAL:
+		Fluxes_1D_V(FLUX_CENTRAL, a, alpha_dx, u, F, j0, j1);
+		break;
+	case FLUX_HLL:
+		Fluxes_1D_V(FLUX_HLL, a, alpha_dx, u, F, j0, j1);
+		break;
+	default:
+		Fluxes_1D_V(FLUX_RUSANOV, a, alpha_dx, u, F, j0, j1);
+		break;
+	}
+}
+
+/* The bottom/top wall cells are ordinary lanes: their missing neighbour
+   is masked out of the load and replaced by the cell itself, and their
+   wall flux by the flux on the other side (W[0]=W[1], W[NY]=W[NY-1]). */
+static inline __attribute__((always_inline))
+void Row_2D_V(const struct Coeffs_2D *c, int flux,
+	      const real *Tc, const real *Tw, const real *Te, real *Tn,
+	      int west_wall, int east_wall, int bottom_wall, int top_wall, int cnt)
+{
+	VEC vu = V_DUP(c->u);
+	VEC vv = V_DUP(c->v);
+	VEC vhalf = V_DUP((real)0.5);
+	VEC vhs_u = V_DUP((real)0.5*c->su);
+	VEC vhs_v = V_DUP((real)0.5*c->sv);
+	VEC vkd = V_DUP(c->kd);
+	VEC vdtdx = V_DUP(c->dtdx);
+	VEC vdtdy = V_DUP(c->dtdy);
+	VEC vdt = V_DUP(c->dt);
+	VEC vfour = V_DUP((real)4);
+	int u_pos = c->u > 0;
+	int v_pos = c->v > 0;
+
+	for (int k = 0; k < cnt; k += V_LANES()) {
+		PRED pg = V_WHILELT(k, cnt);
+		PRED p_bot = (bottom_wall && k == 0) ? V_LANE(0) : P_NONE;
+		PRED p_top = top_wall ? V_LANE(cnt-1 - k) : P_NONE;
+
+		VEC C = V_LOAD(pg, Tc + k);
+		VEC Left = V_LOAD(pg, Tw + k);
+		VEC Right = V_LOAD(pg, Te + k);
+		VEC Bottom = V_SEL(p_bot, C, V_LOAD(P_ANDNOT(pg, p_bot), Tc + k - 1));
+		VEC Top = V_SEL(p_top, C, V_LOAD(P_ANDNOT(pg, p_top), Tc + k + 1));
+
+		/* cells on the left/right walls see the same flux on both sides */
+		VEC Fl = west_wall ? Flux_V(flux, u_pos, c->u >= 0, vu, vhalf, vhs_u, C, Right)
+				   : Flux_V(flux, u_pos, c->u >= 0, vu, vhalf, vhs_u, Left, C);
+		VEC Fr = east_wall ? Flux_V(flux, u_pos, c->u >= 0, vu, vhalf, vhs_u, Left, C)
+				   : Flux_V(flux, u_pos, c->u >= 0, vu, vhalf, vhs_u, C, Right);
+
+		VEC Wb = Flux_V(flux, v_pos, c->v >= 0, vv, vhalf, vhs_v, Bottom, C);
+		VEC Wt = Flux_V(flux, v_pos, c->v >= 0, vv, vhalf, vhs_v, C, Top);
+		VEC Wb_wall = V_SEL(p_bot, Wt, Wb);
+		Wt = V_SEL(p_top, Wb, Wt);
+		Wb = Wb_wall;
+
+		VEC D = V_MUL(vkd, V_SUB(V_ADD(V_ADD(V_ADD(Left, Right), Top), Bottom), V_MUL(vfour, C)));
+		VEC res = V_SUB(C, V_MUL(vdtdx, V_SUB(Fr, Fl)));
+		res = V_SUB(res, V_MUL(vdtdy, V_SUB(Wt, Wb)));
+		res = V_ADD(res, V_MUL(vdt, D));
+		V_STORE(pg, Tn + k, res);
+	}
+}
+
+static void SIMD_NAME(Row_2D)(const struct Coeffs_2D *c, int flux,
+			      const real *Tc, const real *Tw, const real *Te, real *Tn,
+			      int west_wall, int east_wall, int bottom_wall, int top_wall, int cnt)
+{
+	switch (flux) {
+	case FLUX_UPWIND:
+		Row_2D_V(c, FLUX_UPWIND, Tc, Tw, Te, Tn, west_wall, east_wall, bottom_wall, top_wall, cnt);
+		break;
+	case FLUX_CENTRAL:
+		Row_2D_V(c, FLUX_CENTRAL, Tc, Tw, Te, Tn, west_wall, east_wall, bottom_wall, top_wall, cnt);
+		break;
+	case FLUX_HLL:
+		Row_2D_V(c, FLUX_HLL, Tc, Tw, Te, Tn, west_wall, east_wall, bottom_wall, top_wall, cnt);
+		break;
+	default:
+		Row_2D_V(c, FLUX_RUSANOV, Tc, Tw, Te, Tn, west_wall, east_wall, bottom_wall, top_wall, cnt);
+		break;
+	}
+}
@@ -0,0 +1,27 @@
+#include "simd.h"
+
+/* one lane: the reference the vector backends are checked against */
+
+#define VEC                 real
+#define PRED                int
+#define V_LANES()           1
+#define V_WHILELT(i, n)     ((i) < (n))
+#define V_LANE(l)           ((l) == 0)
+#define P_NONE              0
+#define P_ANDNOT(a, b)      ((a) && !(b))
+#define V_LOAD(pg, p)       ((pg) ? *(p) : (real)0)
+#define V_STORE(pg, p, v)   do { if (pg) *(p) = (v); } while (0)
+#define V_DUP(x)            ((real)(x))
+#define V_ADD(a, b)         ((a) + (b))
+#define V_SUB(a, b)         ((a) - (b))
+#define V_MUL(a, b)         ((a) * (b))
+#define V_SEL(pg, a, b)     ((pg) ? (a) : (b))
+#define SIMD_NAME(x)        x##_scalar
+
+#include "simd_kernels.h"
+
+const struct Simd_Ops simd_scalar_ops = {
+	"scalar",
+	Fluxes_1D_scalar,
+	Row_2D_scalar,
+};
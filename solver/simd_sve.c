@@ -0,0 +1,47 @@
+#if defined(__aarch64__)
+
+#pragma GCC target("+sve")
+
+#include <arm_sve.h>
+#include "simd.h"
+
+#ifdef USE_DOUBLE
+
+#define VEC                 svfloat64_t
+#define V_LANES()           ((int)svcntd())
+#define V_ALL               svptrue_b64()
+#define V_WHILELT(i, n)     svwhilelt_b64_s32((i), (n))
+#define V_LANE(l)           svcmpeq_n_s64(V_ALL, svindex_s64(0, 1), (l))
+#define V_DUP(x)            svdup_n_f64(x)
+
+#else
+
+#define VEC                 svfloat32_t
+#define V_LANES()           ((int)svcntw())
+#define V_ALL               svptrue_b32()
+#define V_WHILELT(i, n)     svwhilelt_b32_s32((i), (n))
+#define V_LANE(l)           svcmpeq_n_s32(V_ALL, svindex_s32(0, 1), (l))
+#define V_DUP(x)            svdup_n_f32(x)
+
+#endif
+
+#define PRED                svbool_t
+#define P_NONE              svpfalse_b()
+#define P_ANDNOT(a, b)      svbic_b_z(svptrue_b8(), (a), (b))
+#define V_LOAD(pg, p)       svld1((pg), (p))
+#define V_STORE(pg, p, v)   svst1((pg), (p), (v))
+#define V_ADD(a, b)         svadd_x(V_ALL, (a), (b))
+#define V_SUB(a, b)         svsub_x(V_ALL, (a), (b))
+#define V_MUL(a, b)         svmul_x(V_ALL, (a), (b))
+#define V_SEL(pg, a, b)     svsel((pg), (a), (b))
+#define SIMD_NAME(x)        x##_sve
+
+#include "simd_kernels.h"
+
+const struct Simd_Ops simd_sve_ops = {
+	"sve",
+	Fluxes_1D_sve,
+	Row_2D_sve,
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <omp.h>
+#include "solver.h"
+#include "simd.h"
+#include "telemetry.h"
+#include "prof.h"
+#include "field_alloc.h"
+
+/*
+   Persistent-thread 1D stepping.  Thread t owns the cells [c0, c1) and
+   the interfaces [c0, c1) (interface j is left of cell j) for the whole
+   run, and publishes two counters: the steps whose fluxes it has
+   written and the steps whose update it has written.  Step s of thread
+   t then only depends on its neighbours:
+
+       fluxes:  F[c0] reads u[c0-1], and overwrites the F[c0] that
+                thread t-1 reads in its update      -> t-1 updated s-1
+       update:  u[c1-1] needs F[c1] of thread t+1,
+                and overwrites the u[c1-1] that t+1 read for F[c1]
+                                                    -> t+1 fluxed s
+
+   Nothing waits for the far end of the grid, so a slow thread only
+   holds up its neighbours and the slack propagates one slab per step
+   instead of stopping everyone twice per step.  The counters are
+   release-stored after the data they guard and acquire-loaded before
+   it is touched.  Waits spin a while, then yield the CPU, so np above
+   the core count still makes progress.
+*/
+
+#define SLAB_SPINS 1000         /* spins before every sched_yield */
+
+struct Slab_Flags {
+	_Alignas(64) atomic_int fluxed;
+	atomic_int updated;
+};
+
+struct Slab_Sync {
+	int nthreads;
+	struct Slab_Flags *flags;
+};
+
+struct Slab_Sync *Slab_Create(const struct Params *p)
+{
+	struct Slab_Sync *s = Work_Alloc(sizeof(*s));
+
+	s->flags = Work_Alloc_Aligned(p->np*sizeof(*s->flags));
+	s->nthreads = p->np;
+	for (int t = 0; t < p->np; t++) {
+		atomic_init(&s->flags[t].fluxed, 0);
+		atomic_init(&s->flags[t].updated, 0);
+	}
+	return s;
+}
+
+void Slab_Free(struct Slab_Sync *s)
+{
+	if (!s)
+		return;
+	free(s->flags);
+	free(s);
+}
+
+static void Wait_For(atomic_int *flag, int value)
+{
+	int spins = 0;
+
+	if (atomic_load_explicit(flag, memory_order_acquire) >= value)
+		return;
+	PROF_BEGIN(PROF_WAIT);
+	while (atomic_load_explicit(flag, memory_order_acquire) < value) {
+		if (++spins == SLAB_SPINS) {
+			sched_yield();
+			spins = 0;
+		}
+	}
+	PROF_END(PROF_WAIT);
+}
+
+void Advance_Slab_1D(const struct Kernel_1D *kn, const struct Params *p, real *u, real *F,
+		     int step, int next, struct Telemetry *tm)
+{
+	struct Slab_Sync *sync = kn->sync;
+	int n = kn->n;
+	int nthreads = omp_get_num_threads();
+	int t = omp_get_thread_num();
+	double dtdx = kn->dtdx;
+
+	if (nthreads > sync->nthreads) {
+		fprintf(stderr, "slab stepper set up for %d threads, called by %d\n",
+			sync->nthreads, nthreads);
+		exit(1);
+	}
+
+	int c0 = (int)((long)n*t/nthreads);
+	int c1 = (int)((long)n*(t+1)/nthreads);
+	int f0 = Max(c0, 1);            /* interfaces [1, n) */
+	int u0 = Max(c0, 1);            /* cells [1, n-1): the walls stay */
+	int u1 = Min(c1, n - 1);
+	struct Slab_Flags *me = &sync->flags[t];
+	struct Slab_Flags *left = t > 0 ? &sync->flags[t-1] : NULL;
+	struct Slab_Flags *right = t < nthreads - 1 ? &sync->flags[t+1] : NULL;
+
+	if (kn->simd)
+		Simd_Flush_Denormals();
+
+	/* the counters run on from call to call; every call starts and ends
+	   with all of them equal */
+	int done = atomic_load_explicit(&me->updated, memory_order_relaxed);
+	for (int s = step; s < next; s++) {
+		done++;
+
+		PROF_BEGIN(PROF_FLUXES);
+		if (left)
+			Wait_For(&left->updated, done - 1);
+		kn->fluxes_range(kn, u, F, f0, c1);
+		atomic_store_explicit(&me->fluxed, done, memory_order_release);
+		PROF_END(PROF_FLUXES);
+
+		PROF_BEGIN(PROF_UPDATE);
+		if (right)
+			Wait_For(&right->fluxed, done);
+		for (int cell = u0; cell < u1; cell++) {
+			u[cell] = u[cell] - dtdx*(F[cell+1] - F[cell]);
+		}
+		atomic_store_explicit(&me->updated, done, memory_order_release);
+		PROF_END(PROF_UPDATE);
+
+		if (t == 0)
+			Telemetry_Push(tm, s + 1, (s + 1)*p->dt, (double)n*(s + 1 - tm->start_step));
+	}
+
+	/* the caller reads the whole field */
+	PROF_BARRIER();
+}
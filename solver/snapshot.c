@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "snapshot.h"
+#include "field_io.h"
+#include "field_alloc.h"
+
+static void *Writer_Thread(void *arg)
+{
+	struct Snapshot_Writer *w = (struct Snapshot_Writer*)arg;
+
+	pthread_mutex_lock(&w->lock);
+	for (;;) {
+		int b = w->next_write;
+		while (!w->full[b] && !w->quit)
+			pthread_cond_wait(&w->cond, &w->lock);
+		if (!w->full[b])
+			break;    /* quit and nothing left to write */
+		pthread_mutex_unlock(&w->lock);
+
+		double t0 = omp_get_wtime();
+		int err = w->write(w->p, w->name, w->buf[b], w->count, w->step[b], w->time[b]);
+		double t_write = omp_get_wtime() - t0;
+
+		if (w->p->debug)
+			printf("%s step %d: copy %.3f ms (solver), write %.3f ms (background)\n",
+			       w->kind, w->step[b], 1e3*w->copy_time[b], 1e3*t_write);
+
+		pthread_mutex_lock(&w->lock);
+		w->write_total += t_write;
+		w->failed += (err != 0);
+		w->full[b] = 0;
+		w->next_write = (b + 1) % SNAPSHOT_BUFFERS;
+	}
+	pthread_mutex_unlock(&w->lock);
+	return NULL;
+}
+
+int Snapshot_Start(struct Snapshot_Writer *w, const struct Params *p, const char *kind,
+		   const char *name, long count, int every, double interval,
+		   Snapshot_Write_Fn write)
+{
+	memset(w, 0, sizeof(*w));
+	w->p = p;
+	w->kind = kind;
+	w->name = name;
+	w->count = count;
+	w->every = every;
+	w->interval = interval;
+	w->write = write;
+	w->active = every > 0 || interval > 0.0;
+	if (!w->active)
+		return 0;
+
+	for (int b = 0; b < SNAPSHOT_BUFFERS; b++) {
+		/* untouched: the static copy loop of Snapshot_Take is the
+		   first touch, with the row partition of the kernels */
+		w->buf[b] = Field_Alloc(p, count);
+		if (!w->buf[b]) {
+			fprintf(stderr, "allocation failed\n");
+			return -1;
+		}
+	}
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->cond, NULL);
+	if (pthread_create(&w->thread, NULL, Writer_Thread, w) != 0) {
+		fprintf(stderr, "cannot start the %s writer\n", kind);
+		return -1;
+	}
+	return 0;
+}
+
+static int Write_Snapshot(const struct Params *p, const char *name,
+			  const real *data, long count, int step, double time)
+{
+	char path[64];
+	struct Field_Var var = { name, data, count };
+	snprintf(path, sizeof(path), "snap_%06d.fld", step);
+	return Field_Write(path, p, step, time, 1, &var);
+}
+
+int Snapshot_Init(struct Snapshot_Writer *w, const struct Params *p, const char *name, long count)
+{
+	return Snapshot_Start(w, p, "snapshot", name, count, p->snapshot_every, p->snapshot_dt,
+			      Write_Snapshot);
+}
+
+/* index of the last interval that step has reached */
+static long Interval(const struct Snapshot_Writer *w, int step)
+{
+	/* the small slack absorbs step*dt landing a rounding error short */
+	return (long)floor(step*w->p->dt/w->interval + 1e-9);
+}
+
+int Snapshot_Due(const struct Snapshot_Writer *w, int step)
+{
+	if (!w->active || step <= 0)
+		return 0;
+	if (w->every > 0 && step % w->every == 0)
+		return 1;
+	return w->interval > 0.0 && Interval(w, step) > Interval(w, step - 1);
+}
+
+int Snapshot_Next(const struct Snapshot_Writer *w, int step, int nsteps)
+{
+	int next = nsteps;
+
+	if (!w->active)
+		return nsteps;
+	if (w->every > 0) {
+		int s = (step/w->every + 1)*w->every;
+		if (s < next)
+			next = s;
+	}
+	if (w->interval > 0.0) {
+		/* first step of the next interval, corrected for the rounding
+		   of the estimate so that it agrees with Snapshot_Due */
+		long k = Interval(w, step) + 1;
+		int s = (int)ceil(k*w->interval/w->p->dt - 1e-9);
+		while (s > step + 1 && Interval(w, s - 1) >= k)
+			s--;
+		while (Interval(w, s) < k)
+			s++;
+		if (s > step && s < next)
+			next = s;
+	}
+	return next;
+}
+
+void Snapshot_Take(struct Snapshot_Writer *w, const real *field, int step, double time)
+{
+	/* both sides go round the buffers in the same order, so the
+	   snapshots are written in step order */
+	#pragma omp single
+	{
+		w->copy_start = omp_get_wtime();
+		pthread_mutex_lock(&w->lock);
+		if (w->full[w->next_fill]) {
+			w->fill = -1;
+			w->dropped++;
+		} else {
+			w->fill = w->next_fill;
+			w->next_fill = (w->next_fill + 1) % SNAPSHOT_BUFFERS;
+		}
+		pthread_mutex_unlock(&w->lock);
+	}
+	if (w->fill < 0)
+		return;
+
+	real *dst = w->buf[w->fill];
+	#pragma omp for schedule(static)
+	for (long i = 0; i < w->count; i++)
+		dst[i] = field[i];
+
+	#pragma omp single
+	{
+		int b = w->fill;
+		double t_copy = omp_get_wtime() - w->copy_start;
+		pthread_mutex_lock(&w->lock);
+		w->copy_time[b] = t_copy;
+		w->step[b] = step;
+		w->time[b] = time;
+		w->full[b] = 1;
+		w->taken++;
+		w->copy_total += t_copy;
+		pthread_cond_signal(&w->cond);
+		pthread_mutex_unlock(&w->lock);
+	}
+}
+
+void Snapshot_Finish(struct Snapshot_Writer *w)
+{
+	if (!w->active)
+		return;
+
+	pthread_mutex_lock(&w->lock);
+	w->quit = 1;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+	pthread_join(w->thread, NULL);
+
+	printf("%d %ss, %d dropped, %d failed: %.3f ms copy on the solver threads, %.3f ms written in the background\n",
+	       w->taken, w->kind, w->dropped, w->failed, 1e3*w->copy_total, 1e3*w->write_total);
+
+	pthread_mutex_destroy(&w->lock);
+	pthread_cond_destroy(&w->cond);
+	for (int b = 0; b < SNAPSHOT_BUFFERS; b++)
+		Field_Free(w->buf[b]);
+}
@@ -0,0 +1,78 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <pthread.h>
+#include "solver.h"
+
+/*
+   Periodic copies of the solution written by a background thread.
+
+   A copy is due every `every` steps and/or every `interval` of simulated
+   time.  Snapshot_Take copies the field into one of two buffers (all
+   OpenMP threads share the copy) and hands it to the writer thread,
+   which calls the write function while the solver carries on.  If the
+   writer still holds both buffers the copy is dropped and counted
+   instead of waiting for the disk.
+
+   Snapshot_Init sets one up for the snapshot_every / snapshot_dt
+   snapshots (snap_<step>.fld); checkpoint.c uses the same machinery.
+*/
+
+#define SNAPSHOT_BUFFERS 2
+
+/* writes one buffered copy; 0, or -1 after printing why */
+typedef int (*Snapshot_Write_Fn)(const struct Params *p, const char *name,
+				 const real *data, long count, int step, double time);
+
+struct Snapshot_Writer {
+	const struct Params *p;
+	const char *kind;       /* "snapshot", "checkpoint": for the reports */
+	const char *name;       /* variable name */
+	long count;             /* values per copy */
+	int every;              /* steps between copies, 0 = off */
+	double interval;        /* simulated time between copies, 0 = off */
+	Snapshot_Write_Fn write;
+	int active;             /* 0 = nothing configured */
+
+	real *buf[SNAPSHOT_BUFFERS];
+	int full[SNAPSHOT_BUFFERS];
+	int step[SNAPSHOT_BUFFERS];
+	double time[SNAPSHOT_BUFFERS];
+	double copy_time[SNAPSHOT_BUFFERS];
+	int fill;               /* buffer being filled, -1 = dropped */
+	int next_fill;          /* the solver fills the buffers round robin */
+	int next_write;         /* and the writer empties them in the same order */
+	double copy_start;
+	int quit;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+	/* totals for the final report */
+	int taken, dropped, failed;
+	double copy_total, write_total;
+};
+
+/* Starts the writer thread if every or interval is set; 0 or -1 */
+int Snapshot_Start(struct Snapshot_Writer *w, const struct Params *p, const char *kind,
+		   const char *name, long count, int every, double interval,
+		   Snapshot_Write_Fn write);
+
+/* snap_<step>.fld every p->snapshot_every steps / p->snapshot_dt */
+int Snapshot_Init(struct Snapshot_Writer *w, const struct Params *p, const char *name, long count);
+
+/* true if a copy is due after step (1-based step count) */
+int Snapshot_Due(const struct Snapshot_Writer *w, int step);
+
+/* the first step after step that has a copy due, at most nsteps */
+int Snapshot_Next(const struct Snapshot_Writer *w, int step, int nsteps);
+
+/* Called by every thread of the parallel region: parallel copy of
+   field into a free buffer, then hand-off to the writer. */
+void Snapshot_Take(struct Snapshot_Writer *w, const real *field, int step, double time);
+
+/* waits for the pending writes, stops the thread and prints the totals */
+void Snapshot_Finish(struct Snapshot_Writer *w);
+
+#endif
@@ -0,0 +1,62 @@
+#include "solver.h"
+
+static inline real Pulse_Value(const struct Params *p, double x, double y, double shift_x, double shift_y)
+{
+	int inside = (x > p->pulse_x0 + shift_x) && (x < p->pulse_x1 + shift_x);
+	if (p->dim == 2)
+		inside = inside && (y > p->pulse_y0 + shift_y) && (y < p->pulse_y1 + shift_y);
+	return inside ? (real)p->pulse : (real)p->background;
+}
+
+void Pulse_Block(const struct Params *p, double t, const struct Grid_View *g,
+		 int ja, int jb, int ka, int kb)
+{
+	double dx = p->lx / p->nx;
+	double dy = p->ly / p->ny;
+
+	for (int j = ja; j < jb; j++) {
+		real *row = g->data + (long)(j - g->oj)*g->stride - g->ok;
+		for (int k = ka; k < kb; k++) {
+			float x = (j + 0.5) * dx;
+			float y = (k + 0.5) * dy;
+			row[k] = Pulse_Value(p, x, y, p->u*t, p->v*t);
+		}
+	}
+}
+
+/* Parallel "omp for" over j with the kernels' static partition, so that
+   the pages are first touched by the thread that later works on them. */
+void Pulse_Region(const struct Params *p, double t, const struct Grid_View *g,
+		  int ja, int jb, int ka, int kb)
+{
+	#pragma omp for schedule(static)
+	for (int j = ja; j < jb; j++)
+		Pulse_Block(p, t, g, j, j+1, ka, kb);
+}
+
+void Initial_Condition(const struct Params *p, real *T)
+{
+	struct Grid_View g = { T, 0, 0, p->ny };
+	Pulse_Region(p, 0.0, &g, 0, p->nx, 0, p->ny);
+}
+
+void Analytic_Solution(const struct Params *p, real *A)
+{
+	struct Grid_View g = { A, 0, 0, p->ny };
+	Pulse_Region(p, p->t_final, &g, 0, p->nx, 0, p->ny);
+}
+
+int Count_Timesteps(const struct Params *p)
+{
+	real time = 0.0;
+	int timestep;
+
+	for (timestep = 0; timestep < p->max_timesteps; timestep++) {
+		time = time + p->dt;
+		if (time > p->t_final) {
+			timestep++;
+			break;
+		}
+	}
+	return timestep;
+}
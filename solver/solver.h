@@ -0,0 +1,179 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "params.h"
+
+#ifdef USE_DOUBLE
+typedef double real;
+#else
+typedef float real;
+#endif
+
+/*
+   1D: u has n cells, F has n+1 interfaces.
+       du/dt + dF/dx = 0,  F = a*u - alpha*du/dx
+   2D: T has nx*ny cells stored as T[j*ny+k], j along X, k along Y.
+       dT/dt + d(uT)/dx + d(vT)/dy = alpha*(d2T/dx2 + d2T/dy2)
+   Both use dF/dx = 0 on the walls (F[0]=F[1], F[n]=F[n-1]).
+
+   Coefficients are worked out once from the Params, and the kernel
+   functions are picked once: common grid sizes and every flux scheme
+   have their own copy with the loop bounds and scheme compiled in, so
+   the runtime-configured path constant-folds like the old #define
+   builds did.  The kernels use orphaned "omp for" loops and are called
+   by every thread of an enclosing parallel region.
+*/
+
+struct Kernel_1D;
+struct Kernel_2D;
+struct Simd_Ops;
+struct Split_1D;
+struct Split_2D;
+struct Slab_Sync;
+struct Tile_Sched;
+struct Telemetry;
+
+/* the 2D coefficients in working precision, for the SIMD kernels */
+struct Coeffs_2D {
+	real u, v;
+	real kd, dtdx, dtdy, dt;
+	real su, sv;            /* Rusanov dissipation speeds */
+};
+
+/* a rectangle of cells held in some buffer: cell (j,k) of the global
+   grid is data[(j-oj)*stride + (k-ok)] */
+struct Grid_View {
+	real *data;
+	int oj, ok;
+	int stride;
+};
+
+typedef void (*Fluxes_1D_Fn)(const struct Kernel_1D *k, const real *u, real *F);
+typedef void (*Update_1D_Fn)(const struct Kernel_1D *k, const real *F, real *u);
+typedef void (*Fluxes_Range_1D_Fn)(const struct Kernel_1D *k, const real *u, real *F, int j0, int j1);
+typedef void (*Step_2D_Fn)(const struct Kernel_2D *k, const real *T, real *Tnew);
+typedef void (*Region_2D_Fn)(const struct Kernel_2D *k, const struct Grid_View *src,
+			     const struct Grid_View *dst, int ja, int jb, int ka, int kb);
+
+struct Kernel_1D {
+	int n;
+	real a;                 /* advection speed */
+	double alpha_dx;        /* alpha/dx */
+	double dtdx;            /* dt/dx */
+	Fluxes_1D_Fn fluxes;
+	Update_1D_Fn update;
+	Fluxes_Range_1D_Fn fluxes_range;        /* serial, interfaces [j0,j1) */
+	int own_fluxes;         /* update computes the fluxes it needs (strang) */
+	int flux;
+	const struct Simd_Ops *simd;    /* NULL unless simd != off */
+
+	/* MUSCL / SSP-RK path only (muscl.c) */
+	int limiter, rk;
+	real *stage;            /* RK stage, n cells */
+	real *stage_flux;       /* fluxes of the later stages, n+1 */
+
+	struct Split_1D *split;         /* implicit diffusion only (split.c) */
+	struct Slab_Sync *sync;         /* slab=1 only (slab.c) */
+};
+
+struct Kernel_2D {
+	int nx, ny;
+	real u, v;
+	real su, sv;            /* Rusanov dissipation speeds */
+	double kd;              /* alpha/dy^2 */
+	double dtdx, dtdy, dt;
+	Step_2D_Fn step;
+	Region_2D_Fn region;
+	int flux;
+	const struct Simd_Ops *simd;    /* NULL unless simd != off */
+	struct Coeffs_2D c;
+
+	/* MUSCL / SSP-RK path only (muscl.c) */
+	int limiter, rk;
+	real *stage;            /* RK stage, nx*ny cells */
+	real *scratch;          /* 4 slope rows of ny per thread */
+
+	struct Split_2D *split;         /* implicit diffusion only (split.c) */
+	struct Tile_Sched *sched;       /* steal=1 only (sched.c) */
+};
+
+void Kernel_1D_Init(struct Kernel_1D *k, const struct Params *p);
+void Kernel_2D_Init(struct Kernel_2D *k, const struct Params *p);
+
+/* releases what the MUSCL and implicit diffusion paths allocated */
+void Kernel_1D_Free(struct Kernel_1D *k);
+void Kernel_2D_Free(struct Kernel_2D *k);
+
+/* zeroes the kernel's own field-sized work arrays with the row partition
+   of the step (Field_First_Touch); called by every thread of the
+   parallel region before the first step */
+void Kernel_2D_First_Touch(const struct Kernel_2D *k);
+
+/* switch an initialized kernel to another time step (adaptive.c) */
+void Kernel_1D_Set_Dt(struct Kernel_1D *k, const struct Params *p, double dt);
+void Kernel_2D_Set_Dt(struct Kernel_2D *k, const struct Params *p, double dt);
+
+/* F[1..n-1]; the wall values F[0], F[n] are only needed for output */
+static inline void Compute_Fluxes_1D(const struct Kernel_1D *k, const real *u, real *F)
+{
+	if (!k->own_fluxes)
+		k->fluxes(k, u, F);
+}
+
+/* after the last step: the fluxes of u for the output, which the
+   stepping loop left out when the update computes its own */
+static inline void Output_Fluxes_1D(const struct Kernel_1D *k, const real *u, real *F)
+{
+	if (k->own_fluxes)
+		k->fluxes(k, u, F);
+}
+
+static inline void Update_State_1D(const struct Kernel_1D *k, const real *F, real *u)
+{
+	k->update(k, F, u);
+}
+
+/* fused flux + update: reads T, writes only Tnew */
+static inline void Compute_Step_2D(const struct Kernel_2D *k, const real *T, real *Tnew)
+{
+	k->step(k, T, Tnew);
+}
+
+/*
+   Temporally blocked 2D stepping: advances nsteps steps, time_block
+   steps at a time per tile_x x tile_y tile (see tiling.c).  Called by
+   every thread of a parallel region with its own copy of *T / *Tnew;
+   on return *T holds the result.  Bitwise identical to calling
+   Compute_Step_2D nsteps times.
+*/
+void Advance_Blocked_2D(const struct Kernel_2D *k, const struct Params *p,
+			real **T, real **Tnew, int nsteps);
+
+/*
+   Persistent-thread 1D stepping (slab=1, slab.c): advances the steps
+   [step, next), each thread on its own slab of cells, waiting only for
+   its two neighbours.  Called by every thread of a parallel region;
+   bitwise identical to the Compute_Fluxes_1D / Update_State_1D loop.
+*/
+void Advance_Slab_1D(const struct Kernel_1D *k, const struct Params *p, real *u, real *F,
+		     int step, int next, struct Telemetry *tm);
+
+/* the neighbour flags of the slab stepper; NULL, or exits on failure */
+struct Slab_Sync *Slab_Create(const struct Params *p);
+void Slab_Free(struct Slab_Sync *s);
+
+/* number of steps the "time += dt; if (time > t_final) break" loop takes */
+int Count_Timesteps(const struct Params *p);
+
+/* initial square pulse and the exact (advected, undiffused) solution */
+void Initial_Condition(const struct Params *p, real *T);
+void Analytic_Solution(const struct Params *p, real *A);
+
+/* the pulse at time t on the cells [ja,jb) x [ka,kb) of g; Pulse_Region
+   is an "omp for" over j, Pulse_Block the serial version */
+void Pulse_Region(const struct Params *p, double t, const struct Grid_View *g,
+		  int ja, int jb, int ka, int kb);
+void Pulse_Block(const struct Params *p, double t, const struct Grid_View *g,
+		 int ja, int jb, int ka, int kb);
+
+#endif
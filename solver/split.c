@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include "split.h"
+#include "implicit.h"
+#include "multigrid.h"
+#include "field_alloc.h"
+
+/* ---------------------------------------------------------------- 1D */
+
+static void Lie_Update_1D(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	const struct Split_1D *s = kn->split;
+
+	s->update(kn, F, u);
+	Implicit_1D_Diffuse(s->diffusion, u);
+}
+
+/* the advection needs the fluxes after the first half step, so the
+   kernel has own_fluxes set and the caller's F is neither computed nor
+   read; Output_Fluxes_1D fills it once after the last step */
+static void Strang_Update_1D(const struct Kernel_1D *kn, const real *F, real *u)
+{
+	const struct Split_1D *s = kn->split;
+
+	(void)F;
+	Implicit_1D_Diffuse(s->diffusion, u);
+	s->fluxes(kn, u, s->flux);
+	s->update(kn, s->flux, u);
+	Implicit_1D_Diffuse(s->diffusion, u);
+}
+
+void Split_1D_Set_Dt(struct Split_1D *s, double dt)
+{
+	Implicit_1D_Set_Dt(s->diffusion, s->strang ? 0.5*dt : dt);
+}
+
+void Split_1D_Init(struct Kernel_1D *k, const struct Params *p)
+{
+	struct Split_1D *s = Work_Alloc(sizeof *s);
+
+	s->strang = (p->splitting == SPLIT_STRANG);
+	s->fluxes = k->fluxes;
+	s->update = k->update;
+	s->diffusion = Implicit_1D_Create(p);
+	if (s->strang) {
+		s->flux = Field_Alloc(p, k->n + 1);
+		if (!s->flux) {
+			fprintf(stderr, "allocation failed\n");
+			exit(1);
+		}
+	}
+
+	k->alpha_dx = 0.0;
+	k->update = s->strang ? Strang_Update_1D : Lie_Update_1D;
+	k->own_fluxes = s->strang;
+	k->split = s;
+	Split_1D_Set_Dt(s, p->dt);
+}
+
+void Split_1D_Free(struct Split_1D *s)
+{
+	if (!s)
+		return;
+	Implicit_1D_Free(s->diffusion);
+	Field_Free(s->flux);
+	free(s);
+}
+
+/* ---------------------------------------------------------------- 2D */
+
+static void Diffuse_2D(const struct Split_2D *s, const real *src, real *dst)
+{
+	if (s->adi)
+		Implicit_2D_Diffuse(s->adi, src, dst);
+	else
+		Multigrid_Diffuse(s->mg, src, dst);
+}
+
+static void Lie_Step_2D(const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	const struct Split_2D *s = kn->split;
+
+	s->advect(kn, T, Tnew);
+	Diffuse_2D(s, Tnew, Tnew);
+}
+
+static void Strang_Step_2D(const struct Kernel_2D *kn, const real *T, real *Tnew)
+{
+	const struct Split_2D *s = kn->split;
+
+	Diffuse_2D(s, T, s->half);
+	s->advect(kn, s->half, Tnew);
+	Diffuse_2D(s, Tnew, Tnew);
+}
+
+void Split_2D_Set_Dt(struct Split_2D *s, double dt)
+{
+	double d = s->strang ? 0.5*dt : dt;
+
+	if (s->adi)
+		Implicit_2D_Set_Dt(s->adi, d);
+	else
+		Multigrid_Set_Dt(s->mg, d);
+}
+
+void Split_2D_Init(struct Kernel_2D *k, const struct Params *p)
+{
+	struct Split_2D *s = Work_Alloc(sizeof *s);
+
+	s->strang = (p->splitting == SPLIT_STRANG);
+	s->advect = k->step;
+	if (p->diffusion == DIFFUSION_BE)
+		s->mg = Multigrid_Create(p);
+	else
+		s->adi = Implicit_2D_Create(p);
+	if (s->strang) {
+		s->half = Field_Alloc(p, (long)k->nx*k->ny);
+		if (!s->half) {
+			fprintf(stderr, "allocation failed\n");
+			exit(1);
+		}
+	}
+
+	k->kd = 0.0;
+	k->c.kd = 0;
+	k->step = s->strang ? Strang_Step_2D : Lie_Step_2D;
+	k->region = NULL;
+	k->split = s;
+	Split_2D_Set_Dt(s, p->dt);
+}
+
+void Split_2D_First_Touch(const struct Kernel_2D *k)
+{
+	const struct Split_2D *s = k->split;
+
+	if (s->half)
+		Field_First_Touch(s->half, k->nx, k->ny);
+	if (s->adi)
+		Implicit_2D_First_Touch(s->adi);
+	else
+		Multigrid_First_Touch(s->mg);
+}
+
+void Split_2D_Free(struct Split_2D *s)
+{
+	if (!s)
+		return;
+	Implicit_2D_Free(s->adi);
+	Multigrid_Free(s->mg);
+	Field_Free(s->half);
+	free(s);
+}
+
+void Split_2D_Print(const struct Split_2D *s, FILE *fp)
+{
+	if (s->mg)
+		Multigrid_Print(s->mg, fp);
+}
@@ -0,0 +1,50 @@
+#ifndef SPLIT_H
+#define SPLIT_H
+
+#include <stdio.h>
+#include "solver.h"
+
+/*
+   Operator splitting for diffusion=cn|be: the explicit kernels advance
+   advection only (alpha taken out), an implicit solver (implicit.h,
+   multigrid.h) advances diffusion, so dt is bound only by the advective
+   CFL number.
+
+       splitting=strang   D(dt/2) A(dt) D(dt/2)   second order (default)
+       splitting=lie      A(dt) D(dt)             first order, half the solves
+
+   Split_*_Init wraps the kernel's update/step function, so the fixed
+   and adaptive loops drive it unchanged.  Not available with
+   time_block > 1 or main_mpi.
+*/
+
+struct Split_1D {
+	int strang;
+	Fluxes_1D_Fn fluxes;            /* the advection-only kernels */
+	Update_1D_Fn update;
+	struct Implicit_1D *diffusion;
+	real *flux;                     /* fluxes after the first D (strang) */
+};
+
+struct Split_2D {
+	int strang;
+	Step_2D_Fn advect;              /* the advection-only kernel */
+	struct Implicit_2D *adi;        /* diffusion=cn */
+	struct Multigrid *mg;           /* diffusion=be */
+	real *half;                     /* after the first D (strang) */
+};
+
+void Split_1D_Init(struct Kernel_1D *k, const struct Params *p);
+void Split_2D_Init(struct Kernel_2D *k, const struct Params *p);
+void Split_1D_Set_Dt(struct Split_1D *s, double dt);
+void Split_2D_Set_Dt(struct Split_2D *s, double dt);
+void Split_1D_Free(struct Split_1D *s);
+void Split_2D_Free(struct Split_2D *s);
+
+/* Kernel_2D_First_Touch for the splitting and solver buffers */
+void Split_2D_First_Touch(const struct Kernel_2D *k);
+
+/* solver statistics, if the diffusion solver keeps any */
+void Split_2D_Print(const struct Split_2D *s, FILE *fp);
+
+#endif
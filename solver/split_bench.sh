@@ -0,0 +1,24 @@
+#!/bin/sh
+# Explicit against operator-split implicit diffusion on a ladder of 2D
+# grids (make first).
+#   ./split_bench.sh [extra key=value ...]
+# All runs use adaptive dt at the same CFL number: the explicit one is
+# bound by diffusion on fine grids, the split ones only by advection.
+
+RUN="./main configs/2d_a_d.cfg debug=0 t_final=0.2 alpha=1e-3 adaptive=1 cfl=0.4 max_timesteps=1000000"
+
+run() {
+	name=$1
+	shift
+	for n in 200 400 800 1600; do
+		$RUN nx=$n ny=$n "$@" | awk -v name="$name" -v n=$n '
+			/Total error/ { err = $3 }
+			/steps in/ { steps = $1; t = $4 }
+			END { printf("%-12s %5d  error %-12g %7d steps %10g s\n", name, n, err, steps, t) }'
+	done
+}
+
+run "explicit" "$@"
+run "cn strang" diffusion=cn "$@"
+run "cn lie" diffusion=cn splitting=lie "$@"
+run "be strang" diffusion=be "$@"
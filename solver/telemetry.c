@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "telemetry.h"
+#include "field_alloc.h"
+
+#define TELEMETRY_POLL 0.01     /* longest drain interval, s */
+
+/* the records pushed so far into the totals; the consumer only */
+static void Drain(struct Telemetry *tm)
+{
+	for (;;) {
+		struct Telemetry_Slot *s = &tm->ring[tm->tail & (TELEMETRY_SLOTS - 1)];
+		if (atomic_load_explicit(&s->seq, memory_order_acquire) != tm->tail + 1)
+			return;
+		struct Telemetry_Record rec = s->rec;
+		atomic_store_explicit(&s->seq, tm->tail + TELEMETRY_SLOTS, memory_order_release);
+		tm->tail++;
+
+		/* producers may land out of order */
+		if (rec.step > tm->step) {
+			tm->step = rec.step;
+			tm->time = rec.time;
+		}
+		if (rec.updates > tm->updates)
+			tm->updates = rec.updates;
+		if (rec.wall > tm->wall)
+			tm->wall = rec.wall;
+		tm->records++;
+	}
+}
+
+/* one line for the records since mark, if there are any */
+static void Report(struct Telemetry *tm, struct Telemetry_Mark *mark)
+{
+	const struct Params *p = tm->p;
+	double dwall = tm->wall - mark->wall;
+
+	if (tm->step == mark->step || dwall <= 0.0)
+		return;
+
+	double eta = -1.0;
+	if (tm->nsteps > 0)
+		eta = (tm->nsteps - tm->step)*dwall/(tm->step - mark->step);
+	else if (tm->time > mark->time)
+		eta = (p->t_final - tm->time)*dwall/(tm->time - mark->time);
+
+	fprintf(stderr, "progress: step %d", tm->step);
+	if (tm->nsteps > 0)
+		fprintf(stderr, "/%d (%.1f%%)", tm->nsteps,
+			100.0*(tm->step - tm->start_step)/(tm->nsteps - tm->start_step));
+	fprintf(stderr, "  t %g  %.4g cell updates/s", tm->time, (tm->updates - mark->updates)/dwall);
+	if (eta >= 0.0)
+		fprintf(stderr, "  ETA %.3g s", eta);
+	fprintf(stderr, "\n");
+	tm->lines++;
+
+	*mark = (struct Telemetry_Mark){ tm->step, tm->time, tm->updates, tm->wall };
+}
+
+static void *Consumer_Thread(void *arg)
+{
+	struct Telemetry *tm = (struct Telemetry*)arg;
+	/* drain often enough that the ring rarely fills, report less often */
+	double poll = fmin(0.1*tm->p->progress, TELEMETRY_POLL);
+	double next_report = tm->start_wall + tm->p->progress;
+
+	pthread_mutex_lock(&tm->lock);
+	while (!tm->quit) {
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME, &until);
+		long ns = until.tv_nsec + (long)(1e9*poll);
+		until.tv_sec += ns / 1000000000L;
+		until.tv_nsec = ns % 1000000000L;
+		pthread_cond_timedwait(&tm->cond, &tm->lock, &until);
+		if (tm->quit)
+			break;
+		pthread_mutex_unlock(&tm->lock);
+
+		Drain(tm);
+		if (omp_get_wtime() >= next_report) {
+			Report(tm, &tm->mark);
+			next_report = omp_get_wtime() + tm->p->progress;
+		}
+
+		pthread_mutex_lock(&tm->lock);
+	}
+	pthread_mutex_unlock(&tm->lock);
+	return NULL;
+}
+
+int Telemetry_Start(struct Telemetry *tm, const struct Params *p, int start_step, int nsteps)
+{
+	memset(tm, 0, sizeof(*tm));
+	tm->p = p;
+	tm->start_step = start_step;
+	tm->step = start_step;
+	tm->nsteps = nsteps;
+	tm->active = p->progress > 0.0;
+	if (!tm->active)
+		return 0;
+
+	tm->ring = Work_Alloc(TELEMETRY_SLOTS*sizeof(*tm->ring));
+	for (unsigned long i = 0; i < TELEMETRY_SLOTS; i++)
+		atomic_init(&tm->ring[i].seq, i);
+	atomic_init(&tm->head, 0);
+	atomic_init(&tm->dropped, 0);
+	tm->start_wall = tm->wall = omp_get_wtime();
+	tm->mark = (struct Telemetry_Mark){ start_step, 0.0, 0.0, tm->start_wall };
+
+	pthread_mutex_init(&tm->lock, NULL);
+	pthread_cond_init(&tm->cond, NULL);
+	if (pthread_create(&tm->thread, NULL, Consumer_Thread, tm) != 0) {
+		fprintf(stderr, "cannot start the progress thread\n");
+		return -1;
+	}
+	return 0;
+}
+
+void Telemetry_Finish(struct Telemetry *tm)
+{
+	if (!tm->active)
+		return;
+
+	pthread_mutex_lock(&tm->lock);
+	tm->quit = 1;
+	pthread_cond_signal(&tm->cond);
+	pthread_mutex_unlock(&tm->lock);
+	pthread_join(tm->thread, NULL);
+	Drain(tm);
+	Report(tm, &tm->mark);
+
+	unsigned long dropped = atomic_load(&tm->dropped);
+	if (tm->p->debug)
+		printf("progress: %ld records, %lu dropped, %d lines\n", tm->records, dropped, tm->lines);
+
+	pthread_mutex_destroy(&tm->lock);
+	pthread_cond_destroy(&tm->cond);
+	free(tm->ring);
+	tm->ring = NULL;
+	tm->active = 0;
+}
@@ -0,0 +1,108 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "params.h"
+
+/*
+   Progress reports (progress=<seconds>) without output in the time loop.
+
+   The solver pushes one fixed-size record per step (or per block of
+   steps) into a bounded lock-free ring: a compare-and-swap on the head
+   and a release store of the slot's sequence number, no lock, no system
+   call, and any number of producer threads.  When the ring is full the
+   record is dropped and counted rather than waiting; the records hold
+   running totals, so a dropped one only costs resolution.  A background
+   thread drains the ring every few milliseconds and, at most once per
+   `progress` seconds, prints one line on stderr: step, simulated time,
+   cell updates/s since the last line and the ETA (from the step count,
+   or from the simulated time left with adaptive=1).
+
+   With progress=0 Telemetry_Push is one predictable branch.
+*/
+
+#define TELEMETRY_SLOTS 1024    /* power of 2 */
+
+struct Telemetry_Record {
+	int step;               /* steps done, 1-based */
+	double time;            /* simulated time reached */
+	double updates;         /* cell updates since Telemetry_Start */
+	double wall;            /* omp_get_wtime() at the push */
+};
+
+struct Telemetry_Slot {
+	atomic_ulong seq;       /* == position: free, position+1: holds a record */
+	struct Telemetry_Record rec;
+};
+
+/* the consumer's view at the last line printed */
+struct Telemetry_Mark {
+	int step;
+	double time, updates, wall;
+};
+
+struct Telemetry {
+	const struct Params *p;
+	int active;             /* 0 = progress off */
+	int start_step;
+	int nsteps;             /* last step, 0 = unknown (adaptive) */
+
+	struct Telemetry_Slot *ring;
+	_Alignas(64) atomic_ulong head;         /* producers */
+	_Alignas(64) atomic_ulong dropped;
+	_Alignas(64) unsigned long tail;        /* the consumer only */
+
+	/* the consumer's view: the latest record */
+	int step;
+	double time, updates, wall;
+	double start_wall;
+	long records;
+	int lines;
+	struct Telemetry_Mark mark;
+
+	int quit;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+/* Starts the consumer if p->progress > 0; nsteps = 0 when the step
+   count is not known up front.  0 or -1 */
+int Telemetry_Start(struct Telemetry *tm, const struct Params *p, int start_step, int nsteps);
+
+/* any thread, any time between Start and Finish; never blocks */
+static inline void Telemetry_Push(struct Telemetry *tm, int step, double time, double updates)
+{
+	if (!tm->active)
+		return;
+
+	unsigned long pos = atomic_load_explicit(&tm->head, memory_order_relaxed);
+	for (;;) {
+		struct Telemetry_Slot *s = &tm->ring[pos & (TELEMETRY_SLOTS - 1)];
+		long dif = (long)(atomic_load_explicit(&s->seq, memory_order_acquire) - pos);
+
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&tm->head, &pos, pos + 1,
+								  memory_order_relaxed, memory_order_relaxed)) {
+				s->rec = (struct Telemetry_Record){ step, time, updates, omp_get_wtime() };
+				atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+				return;
+			}
+		} else if (dif < 0) {
+			/* full: the consumer is a lap behind */
+			atomic_fetch_add_explicit(&tm->dropped, 1, memory_order_relaxed);
+			return;
+		} else {
+			pos = atomic_load_explicit(&tm->head, memory_order_relaxed);
+		}
+	}
+}
+
+/* stops the consumer, drains the ring and prints a last line for the
+   records since the previous one, so a run shorter than progress
+   seconds still reports once */
+void Telemetry_Finish(struct Telemetry *tm);
+
+#endif